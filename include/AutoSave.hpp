@@ -0,0 +1,80 @@
+#ifndef AUTOSAVE_HPP
+#define AUTOSAVE_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <istream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Building.hpp"
+#include "Street.hpp"
+
+class City;
+
+// copie consistenta a starii orasului la un tick; cladirile sunt inregistrari imutabile
+// partajate cu orasul, deci simularea poate continua cat timp snapshot-ul e scris pe alt fir
+struct CitySnapshot {
+    std::uint64_t tick = 0;
+    std::string name;
+    Money money = 0;
+    std::map<std::string, int> resources;
+    std::map<std::string, long> produced;
+    std::vector<Street> streets;
+    std::vector<std::shared_ptr<const BuildingRecord>> buildings;
+    std::vector<std::size_t> buildingStreets;
+};
+
+// scrie snapshot-ul ca text, cu aceleasi sectiuni ca fisierul de scenariu plus PRODUCED;
+// banii sunt cei de dupa cumpararea parcurilor, deci fisierul se citeste cu readSnapshot
+void writeSnapshot(std::ostream& os, const CitySnapshot& snap);
+// citeste inapoi textul scris de writeSnapshot; City::restore reface orasul din el.
+// Tick-ul, upgrade-urile in curs si constructiile neterminate nu sunt salvate
+[[nodiscard]] CitySnapshot readSnapshot(std::istream& in);
+
+// salvare automata la fiecare `interval` tick-uri: captura se face pe firul simularii,
+// serializarea si scrierea pe un fir de fundal. Exista cel mult doua snapshot-uri in
+// memorie (unul in scriere, unul in asteptare); daca ambele sunt ocupate, salvarea se sare.
+// Fisierul e scris intai ca `path.tmp`, sincronizat pe disc si apoi redenumit peste `path`;
+// directorul e sincronizat si el, ca redenumirea sa supravietuiasca unei caderi.
+class AutoSaver {
+    std::string path_;
+    std::uint64_t interval_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::optional<CitySnapshot> pending_;
+    bool writing_ = false;
+    bool stop_ = false;
+    std::uint64_t saved_ = 0;
+    std::uint64_t skipped_ = 0;
+    std::uint64_t lastSavedTick_ = 0;
+    std::exception_ptr error_;
+    std::thread worker_;
+
+    void run();
+    void writeFile(const CitySnapshot& snap) const;
+    void rethrowError();
+
+public:
+    AutoSaver(std::string path, std::uint64_t interval);
+    ~AutoSaver();
+    AutoSaver(const AutoSaver&) = delete;
+    AutoSaver& operator=(const AutoSaver&) = delete;
+
+    void onTick(const City& city);
+    void saveNow(const City& city);
+    void flush();
+
+    [[nodiscard]] std::uint64_t saved();
+    [[nodiscard]] std::uint64_t skipped();
+    [[nodiscard]] std::uint64_t lastSavedTick();
+};
+
+#endif // AUTOSAVE_HPP
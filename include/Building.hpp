@@ -1,36 +1,82 @@
 #ifndef BUILDING_HPP
 #define BUILDING_HPP
 
+#include <atomic>
+#include <cstdint>
 #include <functional>
 #include <map>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
+#include "Money.hpp"
+#include "NamePool.hpp"
 #include "ResourcePool.hpp"
 
 class Street;
 class BuildingVisitor;
+struct CatalogTables;
+struct ResidentialTuning;
+struct CommercialTuning;
+
+// ce scrie salvarea pentru o cladire; imutabila, deci poate fi citita de firul de salvare
+struct BuildingRecord {
+    std::string kind;
+    std::string name;
+    std::vector<std::string> params;
+
+    friend bool operator==(const BuildingRecord&, const BuildingRecord&) = default;
+};
+
 class Building {
 protected:
-    std::string name_;
+    NameRef name_;                  // internat in NamePool
+    const Street* street_;          // strada slotului; orasul o leaga din nou cand strazile se muta
     int level_;
     int maxLevel_;
-    static int buildingCount_;
+    int upgradeTicks_ = 0;          // 0 = upgrade instant
+    bool upgrading_ = false;
+    std::uint64_t upgradeDue_ = 0;  // tick-ul la care se termina upgrade-ul programat
+    std::uint64_t revision_ = 0;    // creste la fiecare schimbare de stare; cheia cache-urilor orasului
+    static std::atomic<int> buildingCount_;   // cladirile pot fi construite din mai multe fire
     virtual void printImpl(std::ostream& os) const = 0;
+    void raiseLevel() noexcept;
+    void touch() noexcept;
 
 public:
-    explicit Building(std::string name = "Building", int lvl = 1, int maxL = 3);
+    explicit Building(std::string_view name = "Building", int lvl = 1, int maxL = 3, const Street* st = nullptr);
     virtual ~Building();
-    Building(const Building&) = default;
+    Building(const Building& other);
     Building& operator=(const Building&) = default;
     void print(std::ostream& os) const;
+    [[nodiscard]] std::uint64_t revision() const noexcept;
+    [[nodiscard]] const Street* street() const noexcept { return street_; }
+    void bindStreet(const Street* st) noexcept;
     friend std::ostream& operator<<(std::ostream& os, const Building& b);
     //functii virtuale
-    virtual void upgrade(ResourcePool<int>& cityResources, int& money) = 0;
+    virtual void upgrade(ResourcePool<int>& cityResources, Money& money) = 0;
     [[nodiscard]] virtual std::shared_ptr<Building> clone_shared() const = 0;
     [[nodiscard]] virtual int capacityEffect() const = 0;
+    // parametrii pentru BuildingCreator care recreeaza cladirea la nivelul curent
+    [[nodiscard]] virtual std::vector<std::string> saveParams() const = 0;
+    // octetii ocupati de obiect si de ce aloca el (fara nume, care sunt in NamePool)
+    [[nodiscard]] virtual std::size_t memoryUsage() const = 0;
+    // leaga cladirea de tabelele noi ale catalogului; doar rezidentialele si comercialele tin
+    // valori partajate. Utilitatile, parcurile si fabricile iau din catalog numai implicitele
+    // parametrilor la creare si le pastreaza pe acelea dupa o reincarcare
+    virtual void bindCatalog(const CatalogTables&) {}
     [[nodiscard]] const std::string& name() const noexcept;
+    [[nodiscard]] const NameRef& nameRef() const noexcept;
     [[nodiscard]] int level() const noexcept;
+    [[nodiscard]] int maxLevel() const noexcept;
+    [[nodiscard]] bool isMaxed() const noexcept;
+    [[nodiscard]] bool isUpgrading() const noexcept;
+    [[nodiscard]] int upgradeTicks() const noexcept;
+    void setUpgradeTicks(int ticks);
+    [[nodiscard]] std::uint64_t upgradeDue() const noexcept;
+    void setUpgradeDue(std::uint64_t tick) noexcept;
+    void finishUpgrade() noexcept;
+    void cancelUpgrade() noexcept;
     [[nodiscard]] static int buildingCount() noexcept;
     virtual void accept(BuildingVisitor& v) = 0;
 };
@@ -41,7 +87,7 @@ public:
         std::shared_ptr<Building>(
             const std::string&,
             const std::vector<std::string>&,
-            Street*
+            const Street*
         )
     >;
 
@@ -55,25 +101,27 @@ public:
         const std::string& id,
         const std::string& name,
         const std::vector<std::string>& params,
-        Street* street
+        const Street* street
     ) const;
 };
 
 //clase derivate
 class ResidentialBuilding : public Building {
     int capacityBase_;
-    std::map<std::string,int> resourcesNeeded_;
+    std::shared_ptr<const ResidentialTuning> tuning_;   // resursele cerute la upgrade
     int moneyProducedPerUpgrade_;
-    Street* street_ = nullptr;
 
 protected:
     void printImpl(std::ostream& os) const override;
 
 public:
-    ResidentialBuilding(const std::string& n, int cap, int lvl, const std::map<std::string,int>& resNeeded, int moneyPerUpgrade, Street* st);
-    void upgrade(ResourcePool<int>& cityResources, int& money) override;
+    ResidentialBuilding(const std::string& n, int cap, int lvl, std::shared_ptr<const ResidentialTuning> tuning, int moneyPerUpgrade, const Street* st);
+    void upgrade(ResourcePool<int>& cityResources, Money& money) override;
     [[nodiscard]] std::shared_ptr<Building> clone_shared() const override;
     [[nodiscard]] int capacityEffect() const override;
+    [[nodiscard]] std::vector<std::string> saveParams() const override;
+    [[nodiscard]] std::size_t memoryUsage() const override;
+    void bindCatalog(const CatalogTables& tables) override;
     void accept(BuildingVisitor& v) override;
 };
 
@@ -81,32 +129,40 @@ class UtilityBuilding : public Building {
     double coverage_;
     int moneyCostPerUpgrade_;
     std::string type_;
-    Street* street_ = nullptr;
+    std::uint64_t outageUntil_ = 0;   // 0 = in functiune, altfel tick-ul la care revine
 
 protected:
     void printImpl(std::ostream& os) const override;
 
 public:
-    UtilityBuilding(const std::string& n, std::string t, double cov, int lvl, int moneyCost, Street* st);
-    void upgrade(ResourcePool<int>& cityResources, int& money) override;
+    UtilityBuilding(const std::string& n, std::string t, double cov, int lvl, int moneyCost, const Street* st);
+    void upgrade(ResourcePool<int>& cityResources, Money& money) override;
     [[nodiscard]] std::shared_ptr<Building> clone_shared() const override;
     [[nodiscard]] int capacityEffect() const override;
+    [[nodiscard]] std::vector<std::string> saveParams() const override;
+    [[nodiscard]] std::size_t memoryUsage() const override;
+    // avarie: cat timp e oprita nu acopera nimic
+    void startOutage(std::uint64_t until) noexcept;
+    void endOutage() noexcept;
+    [[nodiscard]] bool isOffline() const noexcept;
+    [[nodiscard]] std::uint64_t outageUntil() const noexcept;
     void accept(BuildingVisitor& v) override;
 };
 
 class Park : public Building {
     double populationBoost_;
     int moneyCost_;
-    Street* street_ = nullptr;
 
 protected:
     void printImpl(std::ostream& os) const override;
 
 public:
-    Park(const std::string& n, double boost, int cost, Street* st);
-    void upgrade(ResourcePool<int>& cityResources, int& money) override;
+    Park(const std::string& n, double boost, int cost, const Street* st, int lvl = 1);
+    void upgrade(ResourcePool<int>& cityResources, Money& money) override;
     [[nodiscard]] std::shared_ptr<Building> clone_shared() const override;
     [[nodiscard]] int capacityEffect() const override;
+    [[nodiscard]] std::vector<std::string> saveParams() const override;
+    [[nodiscard]] std::size_t memoryUsage() const override;
     [[nodiscard]] int cost() const noexcept;
     void accept(BuildingVisitor& v) override;
 
@@ -114,17 +170,25 @@ public:
 
 class CommercialBuilding : public Building {
     int customersPerLevel_;
-    Street* street_ = nullptr;
+    std::shared_ptr<const CommercialTuning> tuning_;   // costul upgrade-ului pe nivel
+    double demand_ = 1.0;             // multiplicatorul cererii, schimbat de evenimente
+    std::uint64_t demandUntil_ = 0;   // tick-ul la care cererea revine la 1
 
 protected:
     void printImpl(std::ostream& os) const override;
 
 public:
-    CommercialBuilding(const std::string& n, int baseCustomers, int lvl, Street* st);
-    void upgrade(ResourcePool<int>& cityResources, int& money) override;
+    CommercialBuilding(const std::string& n, int baseCustomers, int lvl, std::shared_ptr<const CommercialTuning> tuning, const Street* st);
+    void upgrade(ResourcePool<int>& cityResources, Money& money) override;
     [[nodiscard]] std::shared_ptr<Building> clone_shared() const override;
     [[nodiscard]] int capacityEffect() const override;
+    [[nodiscard]] std::vector<std::string> saveParams() const override;
+    [[nodiscard]] std::size_t memoryUsage() const override;
+    void bindCatalog(const CatalogTables& tables) override;
     void accept(BuildingVisitor& v) override;
+    void setDemand(double demand, std::uint64_t until) noexcept;
+    [[nodiscard]] double demand() const noexcept;
+    [[nodiscard]] std::uint64_t demandUntil() const noexcept;
 
 };
 
@@ -135,7 +199,7 @@ public:
 
     void setBuilding(std::shared_ptr<Building> b) noexcept;
 
-    void upgradeSlot(ResourcePool<int>& resources, int& money) const;
+    void upgradeSlot(ResourcePool<int>& resources, Money& money) const;
     void show(std::ostream& os) const;
 
     [[nodiscard]] int capacity() const noexcept;
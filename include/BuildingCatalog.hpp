@@ -0,0 +1,83 @@
+#ifndef BUILDINGCATALOG_HPP
+#define BUILDINGCATALOG_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// valorile de echilibru ale fiecarui tip de cladire; implicitele sunt cele de dinainte de catalog
+struct ResidentialTuning {
+    int defaultCapacity = 10;
+    int defaultMoneyPerUpgrade = 20;
+    std::map<std::string, int> upgradeResources{{"wood", 10}, {"stone", 5}};
+};
+
+struct UtilityTuning {
+    std::string defaultType = "Water";
+    double defaultCoverage = 100.0;
+    int defaultUpgradeCost = 50;
+};
+
+struct ParkTuning {
+    double defaultBoost = 10.0;
+    int defaultCost = 30;
+};
+
+struct CommercialTuning {
+    int defaultCustomers = 50;
+    int upgradeCostPerLevel = 20;
+};
+
+struct FactoryTuning {
+    std::string defaultResource = "wood";
+    int defaultAmount = 5;
+    int defaultCost = 20;
+};
+
+// o versiune completa a catalogului, imutabila dupa publicare; cladirile tin pointeri
+// direct la tabela tipului lor, deci tick-ul nu cauta nimic in catalog
+struct CatalogTables {
+    std::shared_ptr<const ResidentialTuning> residential = std::make_shared<ResidentialTuning>();
+    std::shared_ptr<const UtilityTuning> utility = std::make_shared<UtilityTuning>();
+    std::shared_ptr<const ParkTuning> park = std::make_shared<ParkTuning>();
+    std::shared_ptr<const CommercialTuning> commercial = std::make_shared<CommercialTuning>();
+    std::shared_ptr<const FactoryTuning> factory = std::make_shared<FactoryTuning>();
+};
+
+// catalogul curent; o reincarcare construieste tabele noi si le publica dintr-o data,
+// iar orasele le leaga de cladirile existente la inceputul urmatorului tick. Tabelele
+// utilitatilor, parcurilor si fabricilor sunt doar implicite pentru cladirile create dupa
+class BuildingCatalog {
+    mutable std::mutex mutex_;
+    std::shared_ptr<const CatalogTables> tables_ = std::make_shared<CatalogTables>();
+    std::atomic<std::uint64_t> version_{0};
+    std::string path_;
+    std::filesystem::file_time_type loadedAt_{};
+    std::filesystem::file_time_type failedAt_{};   // stampila ultimei versiuni care nu s-a putut incarca
+
+    BuildingCatalog() = default;
+
+public:
+    static BuildingCatalog& instance();
+    BuildingCatalog(const BuildingCatalog&) = delete;
+    BuildingCatalog& operator=(const BuildingCatalog&) = delete;
+
+    [[nodiscard]] std::shared_ptr<const CatalogTables> current() const;
+    [[nodiscard]] std::uint64_t version() const noexcept;
+
+    // la eroare arunca CityException si tabelele anterioare raman active
+    void load(const std::string& path);
+    void load(std::istream& in);
+    // reincarca fisierul incarcat ultima data daca s-a modificat de atunci; o versiune care
+    // arunca e tinuta minte si nu mai e incercata pana la urmatoarea modificare
+    bool reloadIfChanged();
+
+    [[nodiscard]] static CatalogTables parse(std::istream& in);
+};
+
+#endif // BUILDINGCATALOG_HPP
@@ -0,0 +1,74 @@
+#ifndef BUILDINGQUERY_HPP
+#define BUILDINGQUERY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Building;
+
+enum class BuildingKind : std::uint8_t { Residential, Utility, Park, Commercial, Factory };
+
+[[nodiscard]] const char* kindName(BuildingKind k) noexcept;
+[[nodiscard]] BuildingKind kindOf(Building& b);
+
+// datele cladirilor pe coloane, o linie per cladire
+struct BuildingColumns {
+    std::vector<std::uint8_t> kind;
+    std::vector<std::uint32_t> street;
+    std::vector<std::int32_t> level;
+    std::vector<std::int32_t> maxLevel;
+    std::vector<std::int64_t> capacity;
+
+    void reserve(std::size_t n);
+    void append(BuildingKind k, std::uint32_t st, int lvl, int maxLvl, long long cap);
+    [[nodiscard]] std::size_t size() const noexcept;
+};
+
+enum class Column : std::uint8_t { Kind, Street, Level, MaxLevel, Capacity };
+enum class CompareOp : std::uint8_t { Eq, Ne, Lt, Le, Gt, Ge };
+
+enum GroupKey : unsigned {
+    GroupNone = 0,
+    GroupKind = 1u << 0,
+    GroupStreet = 1u << 1,
+    GroupLevel = 1u << 2
+};
+
+// -1 pe cheile dupa care nu s-a grupat
+struct QueryRow {
+    int kind = -1;
+    long long street = -1;
+    int level = -1;
+    std::uint64_t count = 0;
+    long long sum = 0;
+    long long min = 0;
+    long long max = 0;
+};
+
+class BuildingQuery {
+    struct Predicate {
+        Column lhs;
+        CompareOp op;
+        bool againstColumn;
+        Column rhs;
+        long long value;
+    };
+
+    std::vector<Predicate> where_;
+    unsigned groupBy_ = GroupNone;
+    Column value_ = Column::Capacity;
+
+    void filter(const BuildingColumns& c, std::size_t begin, std::size_t end, std::vector<std::uint8_t>& sel) const;
+
+public:
+    BuildingQuery& where(Column c, CompareOp op, long long value);
+    BuildingQuery& where(Column lhs, CompareOp op, Column rhs);
+    BuildingQuery& groupBy(unsigned keys);
+    BuildingQuery& aggregate(Column c);
+    [[nodiscard]] std::vector<QueryRow> run(const BuildingColumns& data, unsigned threads = 0) const;
+};
+
+#endif // BUILDINGQUERY_HPP
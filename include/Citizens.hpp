@@ -0,0 +1,59 @@
+#ifndef CITIZENS_HPP
+#define CITIZENS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Street.hpp"
+
+class Building;
+
+// cetatenii in layout ECS: fiecare componenta e o coloana separata, indexata dupa entitate;
+// cladirile sunt referite prin pozitia lor in lista de cladiri a orasului (care poate avea goluri)
+class CitizenSystem {
+public:
+    static constexpr std::uint32_t NONE = UINT32_MAX;
+
+private:
+    // componente
+    std::vector<std::uint32_t> home_;
+    std::vector<std::uint32_t> work_;
+    std::vector<float> satisfaction_;
+
+    // date derivate din cladiri, recalculate doar cand se schimba serviciile
+    std::vector<std::uint32_t> buildingStreet_;
+    std::vector<int> counted_;               // locuitori sau locuri de munca create pentru fiecare cladire
+    std::vector<float> streetService_;       // acoperire utilitati + parcuri per locuitor
+    struct OpenJobs {
+        std::uint32_t building;
+        int free;
+    };
+    std::vector<OpenJobs> openJobs_;
+    std::vector<std::uint32_t> jobless_;
+
+    std::uint64_t employed_ = 0;
+    double averageSatisfaction_ = 0.0;
+
+    void spawnResidents(std::uint32_t home, int count);
+    void matchJobs();
+
+public:
+    void rebuild(const std::vector<std::shared_ptr<Building>>& buildings, const std::vector<SlotRef>& placements, std::size_t streetCount);
+    void onBuildingAdded(std::size_t idx, Building& b, const SlotRef& ref);
+    // pozitiile cladirilor ramase nu se schimba; golurile sunt scoase de remapBuildings
+    void removeBuildings(const std::vector<std::uint32_t>& positions);
+    // dupa compactarea orasului: newPosition[vechea pozitie] (NONE pentru golurile scoase)
+    void remapBuildings(const std::vector<std::uint32_t>& newPosition);
+    // dupa upgrade-uri, avarii sau schimbari de cerere: populatia si locurile de munca urmeaza capacitatea
+    void syncCapacity(const std::vector<std::shared_ptr<Building>>& buildings);
+    void refreshServices(const std::vector<std::shared_ptr<Building>>& buildings, const std::vector<SlotRef>& placements, std::size_t streetCount);
+    void update(unsigned threads = 0);
+
+    [[nodiscard]] std::size_t size() const noexcept;
+    [[nodiscard]] std::uint64_t employed() const noexcept;
+    [[nodiscard]] double averageSatisfaction() const noexcept;
+    [[nodiscard]] std::size_t memoryUsage() const noexcept;
+};
+
+#endif // CITIZENS_HPP
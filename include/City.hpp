@@ -1,39 +1,250 @@
 #ifndef CITY_HPP
 #define CITY_HPP
 
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <iosfwd>
 #include <memory>
 #include <string>
 #include <vector>
 #include "Building.hpp"
+#include "BuildingQuery.hpp"
+#include "Citizens.hpp"
+#include "CityEvents.hpp"
+#include "Ledger.hpp"
+#include "Money.hpp"
 #include "Street.hpp"
 #include "ResourcePool.hpp"
+#include "ProductionScheduler.hpp"
+#include "TimeSeries.hpp"
+#include "TimingWheel.hpp"
+
+struct CitySnapshot;
+
+// memoria unui oras pe subsisteme, in octeti
+struct CityMemory {
+    std::array<std::size_t, 5> buildings{};   // pe tip, indexat dupa BuildingKind
+    std::size_t buildingIndex = 0;            // listele de cladiri, sloturi si cladiri active
+    std::size_t streets = 0;
+    std::size_t resources = 0;
+    std::size_t stats = 0;                    // statistici de productie si serii de timp
+    std::size_t names = 0;                    // numele distincte din NamePool folosite de oras
+    std::size_t citizens = 0;
+    std::size_t scheduling = 0;               // roata de lucrari, productia si evenimentele
+    std::size_t ledger = 0;                   // lotul de tranzactii necomis
+    std::size_t other = 0;
+
+    [[nodiscard]] std::size_t total() const noexcept;
+};
+
+// identificator stabil al unei cladiri: intrarea din tabela de identificatori si generatia ei.
+// Ramane valid peste demolarile si compactarile altor cladiri; dupa demolarea cladirii nu mai
+// gaseste nimic, chiar daca intrarea e refolosita (generatia creste la fiecare eliberare)
+struct BuildingId {
+    std::uint32_t index = UINT32_MAX;
+    std::uint32_t generation = 0;
+
+    [[nodiscard]] bool valid() const noexcept { return index != UINT32_MAX; }
+    // intrarea si generatia intr-un singur numar, de ex. cheie pentru zarurile evenimentelor
+    [[nodiscard]] std::uint64_t key() const noexcept { return (std::uint64_t{index} << 32) | generation; }
+    friend bool operator==(const BuildingId&, const BuildingId&) = default;
+};
+
+std::ostream& operator<<(std::ostream& os, const BuildingId& id);
+
+// lucrare programata pe roata: upgrade in curs sau constructie noua (cu slot deja rezervat)
+struct BuildJob {
+    std::shared_ptr<Building> building;
+    bool construction = false;
+    SlotRef slot;
+    BuildingId id;
+};
+
+// o intrare din jurnalul de schimbari folosit de raportul incremental
+struct ChangeRecord {
+    enum class Kind : std::uint8_t { Building, BuildingAdded, BuildingRemoved, Street };
+    std::uint64_t tick = 0;
+    Kind kind = Kind::Building;
+    const Building* building = nullptr;   // identifica cladirea; nu se citeste dupa demolare
+    NameRef name;                         // numele cladirii demolate, tinut cat ramane intrarea
+    SlotRef slot;                         // locul cladirii adaugate/demolate, sau strada
+    std::uint64_t revision = 0;           // revizia strazii cand a fost data spre modificare
+};
 
 class City {
+public:
+    using ErrorHandler = ProductionScheduler::ErrorHandler;
+    static constexpr std::size_t JOURNAL_LIMIT = std::size_t{1} << 16;   // intrari pastrate pentru printChanges
+
+private:
     std::string name_;
-    int money_ = 0;
+    Money money_ = 0;                              // mereu egal cu soldul trezoreriei din registru
     ResourcePool<int> resources_;
     std::vector<Street> streets_;
+    static constexpr std::uint32_t UNPLACED = UINT32_MAX;   // intrare libera sau cladire inca in constructie
+    struct IdSlot {
+        std::uint32_t position = UNPLACED;         // pozitia in buildings_
+        std::uint32_t generation = 0;
+    };
+
+    // cladirile in ordinea adaugarii; o demolare lasa un gol (nullptr) pana la compactare
     std::vector<std::shared_ptr<Building>> buildings_;
+    std::vector<SlotRef> placements_;              // slotul ocupat de fiecare cladire
+    std::vector<BuildingId> ids_;                  // identificatorul fiecarei pozitii
+    std::vector<IdSlot> slots_;                    // tabela de identificatori
+    std::vector<std::uint32_t> freeIds_;           // intrari refolosibile din slots_
+    // textul afisat si inregistrarea de salvare ale unei cladiri, refacute doar cand revizia
+    // cladirii (sau a strazii, pentru text) s-a schimbat; tinute de oras, nu de cladiri
+    struct BuildingCache {
+        std::string rendered;
+        std::uint64_t renderedRevision = UINT64_MAX;
+        std::uint64_t renderedStreet = 0;
+        std::shared_ptr<const BuildingRecord> record;
+        std::uint64_t recordRevision = UINT64_MAX;
+    };
+    mutable std::vector<BuildingCache> caches_;    // dupa intrarea din slots_; golita la eliberare
+    std::size_t holes_ = 0;                        // pozitii goale din buildings_
+    std::vector<std::uint32_t> removedPositions_;  // demolari inca netransmise cetatenilor
+    std::vector<std::uint64_t> streetsWithSpace_;  // bit setat = strada poate avea sloturi libere
+    std::size_t spaceHint_ = 0;                    // primul cuvant din bitmap care poate fi nenul
+
+    // totalurile retelei de strazi, actualizate pe loc la fiecare schimbare; strazile din oras se
+    // schimba doar prin addStreet, widenStreet, extendStreet si ocuparea/eliberarea sloturilor
+    struct StreetTotals {
+        int slots = 0;
+        int freeSlots = 0;
+        Money upkeep = 0;
+    };
+    std::vector<StreetTotals> streetTotals_;       // valorile fiecarei strazi incluse in totaluri
+    int totalSlots_ = 0;
+    int freeSlots_ = 0;
+    Money upkeep_ = 0;
+    ProductionScheduler production_;
+    bool productionDirty_ = true;                  // lanturile se reconstruiesc doar cand se schimba cladirile
+    std::uint64_t tick_ = 0;
+    std::shared_ptr<CityMetrics> metrics_ = std::make_shared<CityMetrics>();   // impartit cu copiile pana la primul esantion
+    bool metricsEnabled_ = true;
+    TimingWheel<BuildJob> wheel_;
+    std::vector<BuildingId> active_;                  // cladiri care pot incepe un upgrade
+    CitizenSystem citizens_;
+    bool citizensEnabled_ = false;
+    unsigned workerThreads_ = 0;                      // firele pentru cetateni; 0 = cate nuclee are masina
+    bool servicesDirty_ = false;                      // s-a schimbat ceva ce afecteaza satisfactia
+    std::uint64_t catalogVersion_;                    // versiunea catalogului legata de cladiri
+    Ledger ledger_;
+    CityEvents events_;
+    bool eventsEnabled_ = false;
+    bool eventsDirty_ = true;                         // tabelele evenimentelor se reconstruiesc
+    bool pricesDirty_ = false;                        // costurile fabricilor se recalculeaza
+    ErrorHandler onError_;                            // gol = erorile sunt afisate
+    std::deque<ChangeRecord> journal_;                // in ordinea tick-urilor
+    std::uint64_t journalStart_ = 0;                  // jurnalul e complet de la acest tick
+    std::uint64_t seenResources_ = 0;                 // versiunea stocului la ultima verificare
+    std::uint64_t resourcesChanged_ = 0;              // tick-ul ultimei schimbari din stoc
+    Money seenMoney_ = 0;
+    std::uint64_t moneyChanged_ = 0;
+
+    void markStreetSpace(std::size_t idx, bool hasSpace);
+    [[nodiscard]] std::size_t findStreetWithSpace();
+    SlotRef placeOnStreet(std::size_t streetIdx);
+    void refreshStreet(std::size_t idx);
+    void bindStreets();
+    [[nodiscard]] BuildingId allocateId();
+    [[nodiscard]] std::size_t positionOf(BuildingId id) const noexcept;
+    BuildingId commitBuilding(std::shared_ptr<Building> b, SlotRef ref, BuildingId id = {});
+    void markKindDirty(Building& b);
+    void flushRemovals();
+    void releaseSlot(const SlotRef& ref);
+    void releaseId(BuildingId id);
+    void cancelConstruction(BuildingId id);
+    void trackUpgrade(const std::shared_ptr<Building>& b, BuildingId id);
+    void rebuildActive();
+    void upgradeActiveBuildings();
+    void recordUpgrade(const Building& b, Money before);
+    void payPark(const Building& b);
+    void runEvents();
+    void reportError(const Building& b, const CityException& e, const char* prefix = "Error on building ") const;
+    void journal(const ChangeRecord& r);
+    void noteChange(const Building& b);
+    void noteEconomy();
+    BuildingCache& cacheAt(std::size_t pos) const;
+    const std::string& renderedAt(std::size_t pos) const;
+    std::shared_ptr<const BuildingRecord> recordAt(std::size_t pos) const;
 
 public:
-    explicit City(std::string n, int startingMoney = 0) noexcept;
+    explicit City(std::string n, Money startingMoney = 0);
     City(const City& other);
     City& operator=(City other) noexcept;
     friend void swap(City& a, City& b) noexcept;
     void addStreet(const Street& s);
-    Street* getStreet(std::size_t idx);
     [[nodiscard]] const Street* getStreet(std::size_t idx) const;
+    [[nodiscard]] std::size_t streetCount() const noexcept;
+    // operatii pe drumuri: totalurile orasului se actualizeaza doar cu diferenta strazii schimbate
+    bool widenStreet(std::size_t idx);
+    bool extendStreet(std::size_t idx, int segment);
+    // intretinerea tuturor strazilor pe tick
+    [[nodiscard]] Money upkeep() const noexcept;
     void addResource(const std::string& type, int amount);
-    void setMoney(int m) noexcept;
-    [[nodiscard]] int money() const noexcept;
-    void addBuilding(const std::string& typeId, const std::string& name, const std::vector<std::string>& params, std::size_t streetIdx);
+    void setMoney(Money m);
+    [[nodiscard]] Money money() const noexcept;
+    // muta bani intre trezorerie si `counterpart`: delta pozitiv intra in trezorerie
+    void transfer(Money delta, Account counterpart, std::string_view memo = {});
+    [[nodiscard]] const Ledger& ledger() const noexcept;
+    void openLedgerLog(const std::string& path, bool truncate = false);
+    void commitLedger();
+    BuildingId addBuilding(const std::string& typeId, const std::string& name, const std::vector<std::string>& params, std::size_t streetIdx);
+    BuildingId addCreatedBuilding(std::shared_ptr<Building> b, std::size_t streetIdx);
+    // identificatorul e dat de acum, dar gaseste cladirea abia dupa terminarea constructiei
+    BuildingId scheduleConstruction(const std::string& typeId, const std::string& name, const std::vector<std::string>& params, std::size_t streetIdx, int ticks);
+    [[nodiscard]] std::size_t pendingJobs() const noexcept;
     void upgradeAllBuildings();
+    void runProduction();
+    void tick();
+    void applyCatalog();
+    // evenimente aleatoare (avarii, cerere, preturi) evaluate la fiecare tick
+    void enableEvents(const EventConfig& config, std::uint64_t seed);
+    // o replica Monte Carlo e o copie a orasului cu alta samanta
+    void seedEvents(std::uint64_t seed) noexcept;
+    [[nodiscard]] const CityEvents* events() const noexcept;
+    [[nodiscard]] std::uint64_t currentTick() const noexcept;
+    [[nodiscard]] const CityMetrics& metrics() const noexcept;
+    // fara metrici tick-ul nu mai esantioneaza, iar istoricul ramane cel de la copiere
+    void setMetricsEnabled(bool enabled) noexcept;
+    // o replica rulata deja pe un fir al ansamblului isi actualizeaza cetatenii pe acelasi fir
+    void setWorkerThreads(unsigned threads) noexcept;
+    // erorile cladirilor din tick (upgrade, productie) ajung aici in loc de consola
+    void setErrorHandler(ErrorHandler handler);
     void upgradeResidentialOnly();
     [[nodiscard]] int maxBuildings() const noexcept;
-    void addBuildingDirect(std::shared_ptr<Building> b);
+    BuildingId addBuildingDirect(std::shared_ptr<Building> b);
+    // O(1): elibereaza slotul de pe strada si lasa un gol in lista, scos la urmatoarea compactare.
+    // O constructie inca in curs e anulata: lucrarea iese de pe roata si slotul rezervat se elibereaza
+    void demolishBuilding(BuildingId id);
+    // scoate golurile lasate de demolari, pastrand ordinea cladirilor si identificatorii;
+    // tick() o face singur cand golurile trec de un sfert din lista. Listele pastreaza doar
+    // capacitatea necesara pana la urmatoarea compactare
+    void compact();
     [[nodiscard]] int remainingSlots() const noexcept;
+    [[nodiscard]] std::size_t buildingTotal() const noexcept;
+    [[nodiscard]] std::vector<BuildingId> buildingIds() const;
+    // nullptr pentru o cladire demolata sau inca in constructie
+    [[nodiscard]] Building* building(BuildingId id) noexcept;
+    [[nodiscard]] const Building* building(BuildingId id) const noexcept;
+    [[nodiscard]] const SlotRef& placement(BuildingId id) const;
     void printSummary() const;
+    // doar ce s-a schimbat in tick-ul `sinceTick` sau dupa el; daca jurnalul nu mai ajunge
+    // atat de departe in urma, afiseaza rezumatul complet
+    void printChanges(std::uint64_t sinceTick) const;
     [[nodiscard]] int totalCapacity() const noexcept;
+    [[nodiscard]] BuildingColumns columns() const;
+    void populateCitizens();
+    [[nodiscard]] const CitizenSystem& citizens() const noexcept;
+    [[nodiscard]] CitySnapshot snapshot() const;
+    // orasul descris de un snapshot (de ex. citit cu readSnapshot): aceleasi strazi, resurse,
+    // statistici si cladiri; banii sunt luati ca atare, deci parcurile nu mai sunt platite
+    [[nodiscard]] static City restore(const CitySnapshot& snap);
+    [[nodiscard]] CityMemory memoryUsage() const;
     ResourcePool<long> producedStats_;
 };
 
@@ -0,0 +1,89 @@
+#ifndef CITYEVENTS_HPP
+#define CITYEVENTS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Building.hpp"
+#include "CounterRng.hpp"
+
+// probabilitatile sunt pe cladire (sau resursa) si pe tick
+struct EventConfig {
+    double utilityFailure = 0.02;
+    int outageTicks = 3;
+    double demandShift = 0.05;      // cladirile comerciale
+    double demandMin = 0.5;
+    double demandMax = 1.5;
+    int demandTicks = 5;
+    double priceShock = 0.05;       // resursele din stocul orasului
+    double priceMin = 0.5;
+    double priceMax = 2.0;
+    int priceTicks = 5;
+};
+
+struct EventStats {
+    std::uint64_t outages = 0;
+    std::uint64_t repairs = 0;
+    std::uint64_t demandShifts = 0;
+    std::uint64_t priceShocks = 0;
+};
+
+// ce s-a schimbat intr-un tick, ca orasul sa stie ce trebuie recalculat
+struct EventOutcome {
+    bool services = false;   // capacitatea unor cladiri
+    bool prices = false;
+};
+
+// evenimente aleatoare reproductibile: fiecare zar e dat de CounterRng din (samanta, tick, cheia
+// cladirii), deci doua orase cu aceeasi samanta evolueaza identic, iar replicile difera doar prin samanta.
+// Zarurile unui tick se arunca pe coloane, pentru toate cladirile unui tip dintr-o data.
+class CityEvents {
+    enum Stream : std::uint32_t { UtilityFailure = 1, DemandShift, DemandLevel, PriceShock, PriceLevel };
+
+    struct PriceState {
+        double factor = 1.0;
+        std::uint64_t until = 0;
+    };
+
+    CounterRng rng_;
+    EventConfig config_;
+    EventStats stats_;
+    std::map<std::string, PriceState> prices_;
+
+    // tabele reconstruite cand se schimba cladirile orasului; nu se copiaza
+    std::vector<UtilityBuilding*> utilities_;
+    std::vector<std::uint64_t> utilityKeys_;
+    std::vector<CommercialBuilding*> shops_;
+    std::vector<std::uint64_t> shopKeys_;
+    std::vector<std::uint64_t> rolls_;
+    std::vector<std::uint64_t> levels_;
+    std::vector<Building*> changed_;          // cladirile atinse de ultimul evaluate()
+
+    void rollAll(std::uint32_t stream, std::uint64_t tick, const std::vector<std::uint64_t>& keys, std::vector<std::uint64_t>& out) const;
+    [[nodiscard]] double between(std::uint64_t bits, double lo, double hi) const noexcept;
+
+public:
+    explicit CityEvents(EventConfig config = {}, std::uint64_t seed = 0);
+    CityEvents(const CityEvents& other);
+    CityEvents& operator=(const CityEvents& other);
+    CityEvents(CityEvents&&) noexcept = default;
+    CityEvents& operator=(CityEvents&&) noexcept = default;
+
+    // keys[i] e cheia stabila a cladirii buildings[i] (identificatorul ei din oras)
+    void rebuild(const std::vector<std::shared_ptr<Building>>& buildings, const std::vector<std::uint64_t>& keys);
+    [[nodiscard]] EventOutcome evaluate(std::uint64_t tick, const std::map<std::string, int>& resources);
+
+    void setSeed(std::uint64_t seed) noexcept;
+    [[nodiscard]] std::uint64_t seed() const noexcept;
+    [[nodiscard]] const EventConfig& config() const noexcept;
+    [[nodiscard]] const EventStats& stats() const noexcept;
+    [[nodiscard]] const std::vector<Building*>& changed() const noexcept;
+    // pretul resursei fata de cel de baza (1 = normal)
+    [[nodiscard]] double price(const std::string& resource) const;
+    [[nodiscard]] std::size_t memoryUsage() const noexcept;
+};
+
+#endif // CITYEVENTS_HPP
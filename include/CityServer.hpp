@@ -0,0 +1,73 @@
+#ifndef CITYSERVER_HPP
+#define CITYSERVER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "BuildingQuery.hpp"
+
+class City;
+
+// server fara interfata: orasele raman in memorie intre comenzi, care vin pe un socket Unix local.
+// Protocol binar little-endian, cu cadre:
+//   cerere:  u32 lungime | u32 id | u8 operatie | argumente
+//   raspuns: u32 lungime | u32 id | u8 stare (0 = ok, 1 = eroare) | rezultat sau mesajul erorii
+// lungimea nu se include pe ea insasi; sirurile sunt u16 lungime + octeti.
+// Clientul poate trimite mai multe cereri fara sa astepte; raspunsurile vin in aceeasi ordine.
+enum class ServerOp : std::uint8_t {
+    CreateCity = 1,   // str nume, i64 bani                        -> u32 oras
+    DropCity,         // u32 oras
+    AddStreet,        // u32 oras, u8 nivel, u8 segmente           -> u32 strada
+    AddResource,      // u32 oras, str resursa, i64 cantitate (in domeniul int)
+    AddBuilding,      // u32 oras, str tip, str nume, u32 strada, u8 n, n x str -> u32 cladire, u32 generatie
+    Tick,             // u32 oras, u32 n (cel mult MAX_TICKS)      -> u64 tick, i64 bani
+    Query,            // u32 oras, u8 n, n x (u8 coloana, u8 op, u8 fata de coloana, u8 coloana | i64 valoare),
+                      // u8 grupare, u8 coloana agregata           -> u32 randuri, randuri x
+                      // (i32 tip, i32 nivel, i64 strada, u64 numar, i64 suma, i64 min, i64 max)
+    Summary,          // u32 oras -> i64 bani, u64 tick, u32 cladiri, u32 sloturi libere, i64 capacitate
+    Snapshot,         // u32 oras -> u32 lungime + textul scris de writeSnapshot
+    Shutdown,
+    ReloadCatalog,    // str cale (goala = ultimul fisier incarcat) -> u8 1 daca s-a reincarcat
+    Demolish,         // u32 oras, u32 cladire, u32 generatie
+    WidenStreet,      // u32 oras, u32 strada                     -> u8 nivel
+    ExtendStreet      // u32 oras, u32 strada, u32 n               -> u32 sloturi ale strazii
+};
+
+class CityServer {
+    struct Resident {
+        std::unique_ptr<City> city;
+        BuildingColumns columns;      // refolosite de interogari pana la urmatoarea modificare
+        bool columnsDirty = true;
+    };
+
+    std::string socketPath_;
+    std::map<std::uint32_t, Resident> cities_;
+    std::uint32_t nextCity_ = 1;
+    bool running_ = false;
+
+    Resident& resident(std::uint32_t id);
+    void execute(ServerOp op, std::string_view args, std::string& out);
+
+public:
+    static constexpr std::size_t MAX_FRAME = std::size_t{1} << 24;
+    // raspunsurile netrimise ale unui client; peste limita cererile lui nu mai sunt citite
+    static constexpr std::size_t MAX_PENDING_OUTPUT = std::size_t{1} << 22;
+    // tick-uri cerute de o singura comanda Tick, ca un client sa nu blocheze serverul
+    static constexpr std::uint32_t MAX_TICKS = 10000;
+
+    explicit CityServer(std::string socketPath);
+    ~CityServer();
+
+    // ruleaza pana la o cerere Shutdown; doar pe sisteme cu socket-uri Unix
+    void run();
+
+    // proceseaza cadrele complete din `in` cat timp `out` e sub MAX_PENDING_OUTPUT,
+    // adauga raspunsurile in `out` si intoarce cati octeti au fost consumati
+    std::size_t process(std::string_view in, std::string& out);
+    [[nodiscard]] bool running() const noexcept;
+};
+
+#endif // CITYSERVER_HPP
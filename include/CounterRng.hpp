@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// generator bazat pe contor: fiecare valoare depinde doar de (samanta, flux, tick, cheie),
+// deci nu are stare si da acelasi rezultat indiferent de firul sau ordinea in care e cerut
+struct CounterRng {
+    std::uint64_t seed = 0;
+
+    // finalizatorul splitmix64
+    static constexpr std::uint64_t mix(std::uint64_t z) noexcept {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    [[nodiscard]] constexpr std::uint64_t bits(std::uint32_t stream, std::uint64_t tick, std::uint64_t key) const noexcept {
+        return mix(mix(seed ^ (std::uint64_t{stream} << 56) ^ tick) + key * 0x9e3779b97f4a7c15ULL);
+    }
+
+    // uniform in [0, 1) din cei 53 de biti de sus
+    [[nodiscard]] constexpr double uniform(std::uint32_t stream, std::uint64_t tick, std::uint64_t key) const noexcept {
+        return static_cast<double>(bits(stream, tick, key) >> 11) * 0x1.0p-53;
+    }
+
+    // acelasi sir de valori ca bits() pentru fiecare cheie, intr-o bucla fara ramificatii
+    void fill(std::uint32_t stream, std::uint64_t tick, const std::uint64_t* keys, std::uint64_t* out, std::size_t n) const noexcept {
+        const std::uint64_t base = mix(seed ^ (std::uint64_t{stream} << 56) ^ tick);
+        for (std::size_t i = 0; i < n; ++i) out[i] = mix(base + keys[i] * 0x9e3779b97f4a7c15ULL);
+    }
+
+    // prag intreg pentru o probabilitate: bits(...) < threshold(p) are sansa p
+    [[nodiscard]] static constexpr std::uint64_t threshold(double p) noexcept {
+        if (p <= 0.0) return 0;
+        if (p >= 1.0) return UINT64_MAX;
+        return static_cast<std::uint64_t>(p * 0x1.0p64);
+    }
+
+    // cheie stabila pentru un nume (FNV-1a), aceeasi la fiecare rulare si pe orice platforma
+    [[nodiscard]] static constexpr std::uint64_t key(std::string_view name) noexcept {
+        std::uint64_t h = 0xcbf29ce484222325ULL;
+        for (char c : name) {
+            h ^= static_cast<unsigned char>(c);
+            h *= 0x100000001b3ULL;
+        }
+        return h;
+    }
+};
@@ -0,0 +1,47 @@
+#ifndef DISTRICTPLANNER_HPP
+#define DISTRICTPLANNER_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+#include "Building.hpp"
+#include "ResourcePool.hpp"
+
+class Street;
+
+// descriere ieftina a unui tip de cladire candidat; planificatorul nu construieste cladiri
+struct PlotOption {
+    std::string typeId;
+    std::string namePrefix;
+    std::vector<std::string> params;
+    int moneyCost = 0;
+    std::map<std::string,int> materials;
+    int capacity = 0;
+    int income = 0;
+};
+
+enum class PlanGoal { Capacity, Income };
+
+struct DistrictPlan {
+    static constexpr std::size_t EMPTY = static_cast<std::size_t>(-1);
+    std::vector<std::size_t> choice;   // pentru fiecare slot: index in optiuni sau EMPTY
+    int score = 0;
+    int moneyCost = 0;
+    std::map<std::string,int> materials;   // totalul materialelor cerute de plan
+    std::size_t nodes = 0;
+    bool exhaustive = false;           // false daca s-a oprit din cauza limitei de timp
+};
+
+class DistrictPlanner {
+    std::vector<PlotOption> options_;
+
+public:
+    explicit DistrictPlanner(std::vector<PlotOption> options);
+    [[nodiscard]] DistrictPlan plan(std::size_t slots, Money money, const ResourcePool<int>& materials, PlanGoal goal, std::chrono::milliseconds timeLimit, unsigned threads = 0) const;
+    [[nodiscard]] std::vector<Slot> materialize(const DistrictPlan& plan, const Street* st) const;
+    [[nodiscard]] const std::vector<PlotOption>& options() const noexcept;
+};
+
+#endif // DISTRICTPLANNER_HPP
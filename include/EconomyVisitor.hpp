@@ -5,11 +5,11 @@
 
 class EconomyTickVisitor : public BuildingVisitor {
     ResourcePool<int>& res_;
-    int& money_;
+    Money& money_;
     ResourcePool<long>& stats_;
 
 public:
-    EconomyTickVisitor(ResourcePool<int>& r, int& m, ResourcePool<long>& s)
+    EconomyTickVisitor(ResourcePool<int>& r, Money& m, ResourcePool<long>& s)
         : res_(r), money_(m), stats_(s) {}
 
     void visit(ResidentialBuilding& b) override { b.upgrade(res_, money_); }
@@ -0,0 +1,71 @@
+#ifndef ENSEMBLE_HPP
+#define ENSEMBLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "CityEvents.hpp"
+#include "Money.hpp"
+
+class City;
+
+// parametrii unui grup de replici; replicile sunt impartite pe rand intre politici
+struct EnsemblePolicy {
+    std::string name = "base";
+    EventConfig events;
+    Money subsidy = 0;    // bani dati fiecarei replici la bifurcare
+};
+
+// rezultatul unei replici dupa toate tick-urile
+struct ReplicaResult {
+    std::size_t replica = 0;
+    std::size_t policy = 0;
+    std::uint64_t seed = 0;
+    Money finalMoney = 0;
+    Money minMoney = 0;
+    long long finalCapacity = 0;
+    std::uint64_t shortfalls = 0;   // upgrade-uri si productii oprite de lipsa resurselor
+    std::uint64_t failures = 0;     // alte erori ale cladirilor (de obicei lipsa banilor)
+    std::uint64_t outages = 0;
+};
+
+// distributia rezultatelor unei politici
+struct PolicySummary {
+    std::string policy;
+    std::size_t replicas = 0;
+    double meanMoney = 0.0;
+    Money moneyP05 = 0;
+    Money moneyP50 = 0;
+    Money moneyP95 = 0;
+    Money worstMoney = 0;           // cel mai mic sold atins de vreo replica
+    double shortfallRate = 0.0;     // partea replicilor cu cel putin o lipsa de resurse
+    double meanShortfalls = 0.0;
+    double meanCapacity = 0.0;
+};
+
+// ruleaza replici ale unui oras de baza: fiecare replica e o copie cu alta samanta pentru evenimente,
+// avansata N tick-uri pe un fir din pool. In memorie sunt doar replicile in lucru (cate una pe fir),
+// iar copiile impart cu orasul de baza istoricul metricilor si tabelele catalogului.
+class EnsembleRunner {
+    std::size_t replicas_;
+    std::uint64_t ticks_;
+    std::uint64_t seed_;
+    std::vector<EnsemblePolicy> policies_;
+
+    [[nodiscard]] ReplicaResult runReplica(const City& base, std::size_t replica) const;
+
+public:
+    using ResultHandler = std::function<void(const ReplicaResult&)>;
+
+    EnsembleRunner(std::size_t replicas, std::uint64_t ticks, std::uint64_t seed = 1);
+    EnsembleRunner& addPolicy(EnsemblePolicy policy);
+
+    // onResult e apelat pe rand (sub lacat), in ordinea terminarii replicilor;
+    // orasul de baza nu trebuie modificat cat timp ruleaza
+    [[nodiscard]] std::vector<PolicySummary> run(const City& base, const ResultHandler& onResult = {}, unsigned threads = 0) const;
+    [[nodiscard]] std::uint64_t replicaSeed(std::size_t replica) const noexcept;
+};
+
+#endif // ENSEMBLE_HPP
@@ -4,27 +4,40 @@
 #include <memory>
 #include <ranges>
 #include <string>
+#include <vector>
 
 #include "Building.hpp"
 #include "Street.hpp"
 #include "Exceptions.hpp"
 #include "BuildingVisitor.hpp"
+#include "MemoryUsage.hpp"
 
 class FactoryBuilding : public Building {
     std::map<std::string,int> production_;
+    std::map<std::string,int> inputs_;
     int costPerProduction_;
-    Street* street_ = nullptr;
 
 protected:
     void printImpl(std::ostream& os) const override {
-        os << "Factory(name=" << name_ << ", production={";
+        os << "Factory(name=" << *name_ << ", production={";
         bool first = true;
         for (const auto& kv : production_) {
             if (!first) os << ", ";
             os << kv.first << ":" << kv.second;
             first = false;
         }
-        os << "}, cost=" << costPerProduction_ << ")";
+        os << "}";
+        if (!inputs_.empty()) {
+            os << ", inputs={";
+            first = true;
+            for (const auto& kv : inputs_) {
+                if (!first) os << ", ";
+                os << kv.first << ":" << kv.second;
+                first = false;
+            }
+            os << "}";
+        }
+        os << ", cost=" << costPerProduction_ << ")";
         if (street_) {
             os << " [street level=" << street_->level()
                << ", segments=" << street_->length() << "]";
@@ -35,18 +48,21 @@ public:
     FactoryBuilding(const std::string& n,
                     const std::map<std::string,int>& prod,
                     int cost,
-                    Street* st)
-        : Building(n, 1, 1), production_(prod), costPerProduction_(cost), street_(st)
+                    const Street* st,
+                    const std::map<std::string,int>& inputs = {})
+        : Building(n, 1, 1, st), production_(prod), inputs_(inputs), costPerProduction_(cost)
     {
         if (production_.empty())
             throw CityException("Factory must produce at least one resource");
         if (costPerProduction_ <= 0)
             throw CityException("Factory must have a positive production cost");
+        for (const auto& kv : inputs_)
+            if (kv.second <= 0) throw CityException("Factory inputs must be positive");
     }
 
     void accept(BuildingVisitor& v) override;
 
-    void upgrade(ResourcePool<int>&, int&) override {
+    void upgrade(ResourcePool<int>&, Money&) override {
     }
 
     [[nodiscard]] std::shared_ptr<Building> clone_shared() const override {
@@ -59,10 +75,35 @@ public:
         return total;
     }
 
-    void produce(ResourcePool<int>& cityResources, int& money, ResourcePool<long>& stats) const {
+    // acelasi format ca la inregistrare: prima resursa produsa, cost, apoi perechile de intrari
+    [[nodiscard]] std::vector<std::string> saveParams() const override {
+        const auto& out = *production_.begin();
+        std::vector<std::string> params{out.first, std::to_string(out.second), std::to_string(costPerProduction_)};
+        for (const auto& kv : inputs_) {
+            params.push_back(kv.first);
+            params.push_back(std::to_string(kv.second));
+        }
+        return params;
+    }
+
+    [[nodiscard]] std::size_t memoryUsage() const override {
+        return sizeof(*this) + mapMemory(production_) + mapMemory(inputs_);
+    }
+
+    [[nodiscard]] const std::map<std::string,int>& outputs() const noexcept { return production_; }
+    [[nodiscard]] const std::map<std::string,int>& inputs() const noexcept { return inputs_; }
+    [[nodiscard]] int cost() const noexcept { return costPerProduction_; }
+
+    void produce(ResourcePool<int>& cityResources, Money& money, ResourcePool<long>& stats) const {
+        for (const auto& kv : inputs_) {
+            if (cityResources.get(kv.first) < kv.second)
+                throw InsufficientResourceException(kv.first);
+        }
         if (!trySpend(money, costPerProduction_))
             throw CityException("Not enough money to activate factory production");
 
+        for (const auto& kv : inputs_)
+            cityResources.consume(kv.first, kv.second);
         for (const auto& kv : production_) {
             cityResources.add(kv.first, kv.second);          // stoc curent (int)
             stats.add(kv.first, static_cast<long>(kv.second)); // total produs (long)
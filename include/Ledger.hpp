@@ -0,0 +1,94 @@
+#ifndef LEDGER_HPP
+#define LEDGER_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Money.hpp"
+#include "NamePool.hpp"
+
+// conturile registrului; trezoreria e contul ale carui sold il vede orasul ca bani
+enum class Account : std::uint8_t {
+    Treasury,
+    Capital,           // sold initial si corectii facute din afara simularii
+    UpgradeIncome,
+    UpgradeExpense,
+    FactoryExpense,
+    ParkPurchase,
+    Administration,
+    Construction       // cladirile unui plan de cartier, platite la adaugarea in oras
+};
+
+inline constexpr std::size_t ACCOUNT_COUNT = 8;
+
+[[nodiscard]] const char* accountName(Account a) noexcept;
+[[nodiscard]] std::optional<Account> accountFromName(std::string_view name) noexcept;
+
+// o tranzactie in partida dubla: suma intra in contul debitat si iese din cel creditat
+struct LedgerEntry {
+    std::uint64_t tick = 0;
+    std::uint64_t seq = 0;
+    NameRef memo;                        // nume internat in NamePool (de obicei cladirea)
+    Money amount = 0;
+    Account debit = Account::Treasury;
+    Account credit = Account::Capital;
+};
+
+// registrul unui oras: tranzactiile se adauga intr-un lot al tick-ului curent, iar commit()
+// scrie tot lotul in jurnal dintr-o singura scriere. Soldurile sunt tinute la zi la fiecare post,
+// deci o tranzactie costa o adaugare in vector si doua adunari.
+class Ledger {
+    std::array<Money, ACCOUNT_COUNT> balances_{};
+    std::vector<LedgerEntry> batch_;
+    std::uint64_t tick_ = 0;
+    std::uint64_t nextSeq_ = 0;
+    std::uint64_t committed_ = 0;
+    std::ofstream log_;
+    std::string logPath_;
+    std::string buffer_;
+
+public:
+    Ledger() = default;
+    // copia (ex. ramura unei simulari) pastreaza soldurile si lotul, dar nu si jurnalul
+    Ledger(const Ledger& other);
+    Ledger& operator=(const Ledger&) = delete;
+    Ledger(Ledger&&) noexcept = default;
+    Ledger& operator=(Ledger&&) noexcept = default;
+    ~Ledger();
+
+    // suma trebuie sa fie pozitiva; sensul e dat de conturi
+    void post(Account debit, Account credit, Money amount, NameRef memo = {});
+    void setTick(std::uint64_t tick) noexcept;
+
+    // deschide jurnalul (adaugare la sfarsit, sau trunchiat); arunca CityException la eroare
+    void openLog(const std::string& path, bool truncate = false);
+    [[nodiscard]] bool hasLog() const noexcept;
+    // scrie lotul curent in jurnal si il goleste; fara jurnal lotul e doar aruncat
+    void commit();
+
+    [[nodiscard]] Money balance(Account a) const noexcept;
+    [[nodiscard]] std::size_t pending() const noexcept;
+    [[nodiscard]] std::uint64_t committed() const noexcept;
+    [[nodiscard]] const std::vector<LedgerEntry>& batch() const noexcept;
+    [[nodiscard]] std::size_t memoryUsage() const noexcept;
+};
+
+// filtru pentru audit; campurile goale nu filtreaza
+struct LedgerFilter {
+    std::optional<Account> account;   // debitat sau creditat
+    std::string memo;
+    std::uint64_t fromTick = 0;
+    std::uint64_t toTick = UINT64_MAX;
+};
+
+// citeste un jurnal scris de Ledger::commit si intoarce tranzactiile care trec de filtru;
+// memo-urile sunt decodate, deci filtrul se compara cu textul original (poate avea spatii)
+[[nodiscard]] std::vector<LedgerEntry> auditLedger(std::istream& in, const LedgerFilter& filter = {});
+
+#endif // LEDGER_HPP
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <map>
+#include <string>
+
+// estimari de memorie pentru containerele standard folosite in oras
+
+// octetii alocati pe heap de un sir (0 daca incape in bufferul intern)
+inline std::size_t stringHeap(const std::string& s) noexcept {
+    const char* data = s.data();
+    const char* self = reinterpret_cast<const char*>(&s);
+    return (data >= self && data < self + sizeof(s)) ? 0 : s.capacity() + 1;
+}
+
+template <typename T>
+std::size_t heapOf(const T&) noexcept { return 0; }
+
+inline std::size_t heapOf(const std::string& s) noexcept { return stringHeap(s); }
+
+// un nod de arbore rosu-negru: trei pointeri si culoarea, plus perechea cheie-valoare
+template <typename K, typename V>
+std::size_t mapMemory(const std::map<K, V>& m) noexcept {
+    constexpr std::size_t NODE_OVERHEAD = 4 * sizeof(void*);
+    std::size_t total = m.size() * (NODE_OVERHEAD + sizeof(typename std::map<K, V>::value_type));
+    for (const auto& kv : m) total += heapOf(kv.first) + heapOf(kv.second);
+    return total;
+}
@@ -0,0 +1,5 @@
+#pragma once
+#include <cstdint>
+
+// banii orasului; 64 de biti ca orasele mari sa nu depaseasca int
+using Money = std::int64_t;
@@ -0,0 +1,81 @@
+#ifndef NAMEPOOL_HPP
+#define NAMEPOOL_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class NameRef;
+
+// numele cladirilor sunt pastrate o singura data; o cladire (sau o tranzactie, sau o intrare
+// din jurnal) tine un NameRef, iar cand dispare ultima referinta numele e scos din pool si locul
+// lui e refolosit, deci demolarile si reconstructiile nu fac pool-ul sa creasca.
+// Pool-ul e impartit pe bucati dupa hash ca firele incarcatorului paralel sa nu se blocheze reciproc.
+class NamePool {
+    static constexpr std::size_t SHARDS = 16;
+
+    struct Entry {
+        std::string name;
+        std::atomic<std::size_t> refs{0};
+        std::size_t shard = 0;
+        bool live = false;   // false = scoasa din index, asteapta sa fie refolosita
+    };
+
+    struct Shard {
+        mutable std::shared_mutex mutex;
+        std::deque<Entry> entries;   // adrese stabile la adaugare
+        std::vector<Entry*> free;
+        std::unordered_map<std::string_view, Entry*> index;
+    };
+
+    std::array<Shard, SHARDS> shards_;
+
+    NamePool() = default;
+    void release(Entry* e) noexcept;
+    friend class NameRef;
+
+public:
+    static NamePool& instance();
+    NamePool(const NamePool&) = delete;
+    NamePool& operator=(const NamePool&) = delete;
+
+    [[nodiscard]] NameRef intern(std::string_view name);
+    // numele care au cel putin o referinta
+    [[nodiscard]] std::size_t size() const;
+    [[nodiscard]] std::size_t memoryUsage() const;
+};
+
+// referinta numarata la un nume din pool; copierea costa un increment atomic
+class NameRef {
+    NamePool::Entry* entry_ = nullptr;
+
+    friend class NamePool;
+    explicit NameRef(NamePool::Entry* e) noexcept : entry_(e) {}   // referinta deja numarata
+
+public:
+    NameRef() noexcept = default;
+    NameRef(const NameRef& other) noexcept : entry_(other.entry_) {
+        if (entry_) entry_->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    NameRef(NameRef&& other) noexcept : entry_(std::exchange(other.entry_, nullptr)) {}
+    NameRef& operator=(NameRef other) noexcept {
+        std::swap(entry_, other.entry_);
+        return *this;
+    }
+    ~NameRef() {
+        if (entry_) NamePool::instance().release(entry_);
+    }
+
+    explicit operator bool() const noexcept { return entry_ != nullptr; }
+    const std::string& operator*() const noexcept { return entry_->name; }
+    const std::string* operator->() const noexcept { return &entry_->name; }
+};
+
+#endif // NAMEPOOL_HPP
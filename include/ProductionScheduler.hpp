@@ -0,0 +1,57 @@
+#ifndef PRODUCTIONSCHEDULER_HPP
+#define PRODUCTIONSCHEDULER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Building.hpp"
+#include "Exceptions.hpp"
+#include "Ledger.hpp"
+#include "ResourcePool.hpp"
+
+class FactoryBuilding;
+
+// ordoneaza fabricile topologic dupa dependentele de resurse (lemn -> scanduri -> mobila)
+// si deconteaza fluxurile fiecarui nivel intr-o singura trecere peste resursele internate
+class ProductionScheduler {
+    struct Flow {
+        std::uint32_t res;
+        int qty;
+    };
+    struct Job {
+        std::shared_ptr<FactoryBuilding> factory;
+        int baseCost;
+        int cost;                           // dupa pretul curent al resursei produse
+        std::uint32_t priceRes;             // prima iesire; UINT32_MAX daca nu are
+        std::uint32_t inBegin, inEnd;
+        std::uint32_t outBegin, outEnd;
+    };
+
+    std::vector<std::string> resourceNames_;
+    std::map<std::string, std::uint32_t> resourceIds_;
+    std::vector<Flow> flows_;
+    std::vector<Job> jobs_;                 // grupate pe niveluri
+    std::vector<std::size_t> levelEnd_;
+    std::vector<std::shared_ptr<FactoryBuilding>> blocked_;   // in cicluri sau dependente de un ciclu
+
+    std::uint32_t intern(const std::string& name);
+
+public:
+    using ErrorHandler = std::function<void(const Building&, const CityException&)>;
+
+    // fabricile dintr-un ciclu (si cele care depind de el) nu intra in productie, ci in blocked()
+    void rebuild(const std::vector<std::shared_ptr<Building>>& buildings);
+    // recalculeaza costul fiecarei fabrici dupa pretul relativ al resursei pe care o produce
+    void applyPrices(const std::function<double(const std::string&)>& price);
+    void run(ResourcePool<int>& resources, Money& money, Ledger& ledger, ResourcePool<long>& stats, const ErrorHandler& onError) const;
+    [[nodiscard]] std::size_t levels() const noexcept;
+    [[nodiscard]] std::size_t factoryCount() const noexcept;
+    [[nodiscard]] const std::vector<std::shared_ptr<FactoryBuilding>>& blocked() const noexcept;
+    [[nodiscard]] std::size_t memoryUsage() const noexcept;
+};
+
+#endif // PRODUCTIONSCHEDULER_HPP
@@ -1,16 +1,20 @@
 #pragma once
+#include <cstdint>
 #include <map>
 #include <string>
+#include <type_traits>
 #include "Exceptions.hpp"
 
 template <typename T>
 class ResourcePool {
     std::map<std::string, T> data_;
+    std::uint64_t version_ = 0;   // creste la fiecare modificare
 
 public:
     void add(const std::string& name, T qty) {
         if (qty < 0) throw CityException("Negative add not allowed");
         data_[name] += qty;
+        ++version_;
     }
 
     T get(const std::string& name) const {
@@ -23,13 +27,15 @@ public:
         auto cur = get(name);
         if (cur < qty) throw InsufficientResourceException(name);
         data_[name] = cur - qty;
+        ++version_;
     }
 
     const std::map<std::string, T>& raw() const noexcept { return data_; }
+    std::uint64_t version() const noexcept { return version_; }
 };
 
 template <typename T>
-bool trySpend(T& money, T cost) {
+bool trySpend(T& money, std::type_identity_t<T> cost) {
     if (money < cost) return false;
     money -= cost;
     return true;
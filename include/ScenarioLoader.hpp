@@ -0,0 +1,21 @@
+#ifndef SCENARIOLOADER_HPP
+#define SCENARIOLOADER_HPP
+
+#include <cstddef>
+#include <istream>
+
+class City;
+
+// incarca sectiunea BUILDINGS in paralel: textul e impartit in bucati la inceputul
+// unei linii "BUILDING", firele parseaza si construiesc cladirile, iar rezultatele
+// intra in oras in ordinea din fisier (aceleasi indici si aceleasi erori ca la incarcarea seriala)
+class ScenarioLoader {
+    unsigned threads_;
+    std::size_t chunkBytes_;
+
+public:
+    explicit ScenarioLoader(unsigned threads = 0, std::size_t chunkBytes = std::size_t{1} << 16);
+    void loadBuildings(std::istream& in, int count, City& city) const;
+};
+
+#endif // SCENARIOLOADER_HPP
@@ -1,22 +1,64 @@
 #ifndef STREET_HPP
 #define STREET_HPP
 
+#include <array>
 #include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <ostream>
 #include <string>
 #include <vector>
+#include "Money.hpp"
 
-constexpr std::size_t MAX_SEGMENTS = 10;
+constexpr std::size_t SEGMENT_CHUNK = 10;               // segmentele sunt tinute in blocuri de cate 10
+constexpr std::size_t MAX_SEGMENTS = std::size_t{1} << 16;
+constexpr int SLOTS_PER_SEGMENT = 2;
+constexpr int MAX_STREET_LEVEL = 3;
+
+// pozitia unei cladiri: strada si slotul de pe strada
+struct SlotRef {
+    std::size_t street = 0;
+    int slot = -1;
+};
 
 class Street {
-    std::vector<int> segments_;
+    using Chunk = std::array<int, SEGMENT_CHUNK>;
+    // blocuri alocate separat: strada creste cu cate un bloc, iar segmentele existente nu se muta
+    std::vector<std::unique_ptr<Chunk>> chunks_;
+    std::size_t length_ = 0;
     int level_ = 1;
+    std::vector<std::uint64_t> occupied_;   // bit setat = slot ocupat
+    std::size_t freeHint_ = 0;              // cuvintele de dinaintea lui sunt pline
+    int usedSlots_ = 0;
+    std::uint64_t revision_ = 0;            // creste cand se schimba ce se afiseaza (segmente, nivel)
+    mutable std::string rendered_;
+    mutable std::uint64_t renderedRevision_ = UINT64_MAX;
 public:
     explicit Street(int lvl = 1) noexcept;
+    // copia isi aloca propriile blocuri
+    Street(const Street& other);
+    Street& operator=(const Street& other);
+    Street(Street&&) noexcept = default;
+    Street& operator=(Street&&) noexcept = default;
     bool addSegment(int seg);
+    // strada cu o banda in plus pe sens; false daca e deja la nivelul maxim
+    bool widen() noexcept;
     [[nodiscard]] int length() const noexcept;
+    [[nodiscard]] int segment(std::size_t idx) const;
     [[nodiscard]] int level() const noexcept;
+    // intretinerea pe tick: pe segment, dupa numarul de benzi
+    [[nodiscard]] Money upkeep() const noexcept;
+    [[nodiscard]] int slotCount() const noexcept;
+    [[nodiscard]] int freeSlots() const noexcept;
+    [[nodiscard]] bool isOccupied(int slot) const noexcept;
+    [[nodiscard]] int firstFreeSlot() const noexcept;
+    int occupySlot();
+    void releaseSlot(int slot);
     [[nodiscard]] std::string roadType() const;
+    [[nodiscard]] std::uint64_t revision() const noexcept;
+    // textul lui operator<<, din cache
+    [[nodiscard]] const std::string& rendered() const;
+    [[nodiscard]] std::size_t memoryUsage() const noexcept;
     friend std::ostream& operator<<(std::ostream& os, const Street& s);
 };
 
@@ -0,0 +1,82 @@
+#ifndef TIMESERIES_HPP
+#define TIMESERIES_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct SeriesSummary {
+    std::uint64_t count = 0;
+    long long sum = 0;
+    long long min = 0;
+    long long max = 0;
+
+    void merge(const SeriesSummary& o) noexcept;
+    [[nodiscard]] double mean() const noexcept;
+};
+
+// serie de timp in buffere circulare, cu niveluri din ce in ce mai grosiere:
+// nivelul 0 tine esantioane brute, nivelul i agrega factor^i esantioane per bucket
+class TimeSeries {
+    struct Bucket {
+        std::uint64_t first = 0;
+        std::uint64_t last = 0;
+        SeriesSummary s;
+    };
+    struct Tier {
+        std::vector<Bucket> ring;  // creste pana la capacitate, apoi e folosit circular
+        std::size_t capacity = 0;
+        std::size_t head = 0;      // urmatoarea pozitie de scris
+        std::size_t size = 0;
+        Bucket pending;            // bucket in curs de agregare
+        std::size_t pendingChildren = 0;
+
+        [[nodiscard]] const Bucket& at(std::size_t i) const;   // 0 = cel mai vechi
+    };
+
+    std::vector<Tier> tiers_;
+    std::size_t factor_;
+    std::size_t window_;
+    double alpha_;
+
+    long long windowSum_ = 0;
+    std::deque<std::pair<std::uint64_t, long long>> minQ_, maxQ_;
+    double ema_ = 0.0;
+    long long last_ = 0;
+    std::uint64_t samples_ = 0;
+    std::uint64_t lastTick_ = 0;
+
+    void push(std::size_t tier, const Bucket& b);
+    void collect(std::size_t tier, std::uint64_t from, std::uint64_t to, SeriesSummary& out) const;
+
+public:
+    explicit TimeSeries(std::size_t capacityPerTier = 1024, std::size_t factor = 16, std::size_t tiers = 4, std::size_t window = 64, double emaAlpha = 0.1);
+    void record(std::uint64_t tick, long long value);
+
+    [[nodiscard]] long long last() const noexcept;
+    [[nodiscard]] double ema() const noexcept;
+    [[nodiscard]] SeriesSummary window() const noexcept;
+    [[nodiscard]] SeriesSummary range(std::uint64_t from, std::uint64_t to) const;
+    [[nodiscard]] std::uint64_t samples() const noexcept;
+    [[nodiscard]] std::size_t memoryUsage() const noexcept;
+};
+
+// istoricul metricilor orasului, esantionat la fiecare tick
+class CityMetrics {
+    TimeSeries money_;
+    TimeSeries capacity_;
+    std::map<std::string, TimeSeries> stock_;
+
+public:
+    void sample(std::uint64_t tick, long long money, long long capacity, const std::map<std::string, int>& stock);
+    [[nodiscard]] const TimeSeries& money() const noexcept;
+    [[nodiscard]] const TimeSeries& capacity() const noexcept;
+    [[nodiscard]] const TimeSeries* stock(const std::string& resource) const;
+    [[nodiscard]] std::size_t memoryUsage() const noexcept;
+};
+
+#endif // TIMESERIES_HPP
@@ -0,0 +1,120 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// roata de temporizare ierarhica: 4 niveluri a cate 64 de sloturi;
+// un tick atinge doar slotul curent, iar nivelurile superioare coboara o data la 64^k tick-uri
+template <typename T>
+class TimingWheel {
+    static constexpr unsigned BITS = 6;
+    static constexpr std::uint64_t SLOTS = std::uint64_t{1} << BITS;
+    static constexpr std::size_t LEVELS = 4;
+
+    struct Entry {
+        std::uint64_t due;
+        T value;
+    };
+    using Bucket = std::vector<Entry>;
+
+    std::array<std::array<Bucket, SLOTS>, LEVELS> levels_;
+    Bucket overflow_;   // mai departe decat acopera nivelurile
+    Bucket late_;       // programate pentru un tick deja trecut
+    std::uint64_t now_ = 0;
+    std::size_t size_ = 0;
+
+    void place(Entry e) {
+        if (e.due <= now_) {
+            late_.push_back(std::move(e));
+            return;
+        }
+        const std::uint64_t delta = e.due - now_;
+        for (std::size_t lvl = 0; lvl < LEVELS; ++lvl) {
+            if (delta < (std::uint64_t{1} << (BITS * (lvl + 1)))) {
+                levels_[lvl][(e.due >> (BITS * lvl)) & (SLOTS - 1)].push_back(std::move(e));
+                return;
+            }
+        }
+        overflow_.push_back(std::move(e));
+    }
+
+    void redistribute(Bucket& bucket) {
+        Bucket moving;
+        moving.swap(bucket);
+        for (auto& e : moving) place(std::move(e));
+    }
+
+public:
+    explicit TimingWheel(std::uint64_t start = 0) noexcept : now_(start) {}
+
+    void schedule(std::uint64_t due, T value) {
+        place(Entry{due, std::move(value)});
+        ++size_;
+    }
+
+    // avanseaza pana la tick-ul `to` si apeleaza fn(due, value) pentru fiecare job scadent
+    template <typename Fn>
+    void advance(std::uint64_t to, Fn&& fn) {
+        while (now_ < to) {
+            ++now_;
+            if ((now_ & ((std::uint64_t{1} << (BITS * LEVELS)) - 1)) == 0) redistribute(overflow_);
+            for (std::size_t lvl = LEVELS - 1; lvl > 0; --lvl) {
+                if ((now_ & ((std::uint64_t{1} << (BITS * lvl)) - 1)) != 0) continue;
+                redistribute(levels_[lvl][(now_ >> (BITS * lvl)) & (SLOTS - 1)]);
+            }
+
+            Bucket due;
+            due.swap(late_);
+            Bucket& slot = levels_[0][now_ & (SLOTS - 1)];
+            for (auto& e : slot) due.push_back(std::move(e));
+            slot.clear();
+            size_ -= due.size();
+            for (auto& e : due) fn(e.due, e.value);
+        }
+    }
+
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (const auto& level : levels_)
+            for (const auto& bucket : level)
+                for (const auto& e : bucket) fn(e.due, e.value);
+        for (const auto& e : overflow_) fn(e.due, e.value);
+        for (const auto& e : late_) fn(e.due, e.value);
+    }
+
+    // scoate de pe roata lucrarile pentru care pred(value) e adevarat; parcurge toate bucket-urile
+    template <typename Pred>
+    std::size_t removeIf(Pred&& pred) {
+        std::size_t removed = 0;
+        auto sweep = [&](Bucket& bucket) {
+            for (std::size_t i = 0; i < bucket.size();) {
+                if (!pred(bucket[i].value)) {
+                    ++i;
+                    continue;
+                }
+                bucket[i] = std::move(bucket.back());
+                bucket.pop_back();
+                ++removed;
+            }
+        };
+        for (auto& level : levels_)
+            for (auto& bucket : level) sweep(bucket);
+        sweep(overflow_);
+        sweep(late_);
+        size_ -= removed;
+        return removed;
+    }
+
+    [[nodiscard]] std::uint64_t now() const noexcept { return now_; }
+    [[nodiscard]] std::size_t size() const noexcept { return size_; }
+
+    // memoria rotii si a bucket-urilor (fara ce aloca valorile programate)
+    [[nodiscard]] std::size_t memoryUsage() const noexcept {
+        std::size_t total = sizeof(*this) + (overflow_.capacity() + late_.capacity()) * sizeof(Entry);
+        for (const auto& level : levels_)
+            for (const auto& bucket : level) total += bucket.capacity() * sizeof(Entry);
+        return total;
+    }
+};
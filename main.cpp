@@ -1,18 +1,39 @@
+#include <chrono>
+#include <filesystem>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string>
 #include <vector>
 #include <map>
 #include <memory>
 
+#include "include/AutoSave.hpp"
 #include "include/City.hpp"
+#include "include/CityServer.hpp"
 #include "include/Building.hpp"
+#include "include/BuildingCatalog.hpp"
+#include "include/BuildingQuery.hpp"
+#include "include/DistrictPlanner.hpp"
+#include "include/Ensemble.hpp"
 #include "include/Factory.hpp"
+#include "include/Ledger.hpp"
 #include "include/Exceptions.hpp"
 #include "include/ResourcePool.hpp"
+#include "include/ScenarioLoader.hpp"
 
-int main() {
+int main(int argc, char* argv[]) {
     try {
+        // valorile de echilibru ale cladirilor; fara catalog raman cele implicite
+        if (std::filesystem::exists("catalog.txt")) BuildingCatalog::instance().load("catalog.txt");
+
+        // mod server: orasele raman in memorie si primesc comenzi pe un socket Unix
+        if (argc > 1 && std::string(argv[1]) == "--serve") {
+            CityServer server(argc > 2 ? argv[2] : "oop.sock");
+            server.run();
+            return 0;
+        }
+
         std::ifstream fin("tastatura.txt");
         if (!fin) {
             std::cerr << "Nu pot deschide fisierul tastatura.txt\n";
@@ -21,20 +42,20 @@ int main() {
 
         std::string tag;
         std::string cityName;
-        int cityMoney = 0;
+        Money cityMoney = 0;
 
         fin >> tag;
         if (tag != "CITY") throw CityException("Missing section CITY");
         fin >> cityName >> cityMoney;
 
         City city(cityName, cityMoney);
+        city.openLedgerLog("ledger.log", true);
 
         {
-            int m = city.money();
-            constexpr int adminTax = 10;
-            if (!trySpend(m, adminTax))
+            constexpr Money adminTax = 10;
+            if (city.money() < adminTax)
                 throw CityException("Not enough money for tax");
-            city.setMoney(m);
+            city.transfer(-adminTax, Account::Administration, "admin_tax");
         }
 
         int streetCount = 0;
@@ -78,22 +99,11 @@ int main() {
         if (tag != "BUILDINGS") throw CityException("Missing section BUILDINGS");
         fin >> buildingCount;
 
-        for (int i = 0; i < buildingCount; ++i) {
-            fin >> tag;
-            if (tag != "BUILDING") throw CityException("Was expecting BUILDING");
-
-            std::string type, name;
-            int streetIndex = 0;
-            int paramCount = 0;
-            fin >> type >> name >> streetIndex >> paramCount;
-
-            std::vector<std::string> params(paramCount);
-            for (int j = 0; j < paramCount; ++j) fin >> params[j];
-
-            city.addBuilding(type, name, params, static_cast<std::size_t>(streetIndex));
-        }
+        ScenarioLoader().loadBuildings(fin, buildingCount, city);
 
         city.addBuilding("factory", "WoodFactory", {"wood", "15", "30"}, 0);
+        city.addBuilding("factory", "PlankMill", {"planks", "5", "10", "wood", "20"}, 1);
+        city.addBuilding("factory", "FurnitureShop", {"furniture", "1", "10", "planks", "5"}, 1);
 
         std::cout << "--- INITIAL CITY STATE ---\n";
         city.printSummary();
@@ -103,25 +113,25 @@ int main() {
         districtMaterials.add("wood", 30);
         districtMaterials.add("stone", 20);
 
-        std::vector<Slot> district;
-
-        district.emplace_back(std::make_shared<ResidentialBuilding>(
-            "BlockA", 5, 1,
-            std::map<std::string,int>{{"wood", 5}, {"stone", 2}},
-            10,
-            city.getStreet(0)
-        ));
-
-        district.emplace_back(std::make_shared<CommercialBuilding>(
-            "ShopA", 30, 1, city.getStreet(0)
-        ));
-
-        district.emplace_back();
-        district[2].setBuilding(std::make_shared<Park>(
-            "PocketPark", 5.0, 0, city.getStreet(0)
-        ));
+        // planificatorul alege tipurile de cladiri pentru sloturile cartierului
+        DistrictPlanner planner({
+            {"residential", "Block", {"5", "1", "10"}, 0, {{"wood", 10}, {"stone", 5}}, 5, 10},
+            {"commercial", "Shop", {"30", "1"}, 20, {}, 30, 0},
+            {"park", "PocketPark", {"5.0", "0"}, 0, {}, 5, 0},
+        });
+        DistrictPlan plan = planner.plan(3, city.money(), districtMaterials, PlanGoal::Capacity, std::chrono::milliseconds(50));
+        std::cout << "Plan score=" << plan.score << ", cost=" << plan.moneyCost << ", nodes=" << plan.nodes
+                  << (plan.exhaustive ? "" : " (time limit reached)") << "\n";
+
+        std::vector<Slot> district = planner.materialize(plan, city.getStreet(0));
+        // cladirile planului se platesc cand sunt construite: banii din trezorerie, materialele din stoc
+        city.transfer(-plan.moneyCost, Account::Construction, "district plan");
+        for (const auto& [material, qty] : plan.materials) districtMaterials.consume(material, qty);
+        for (const auto& slot : district) {
+            if (slot.building()) slot.building()->setUpgradeTicks(2);
+        }
 
-        int localMoney = city.money();
+        Money localMoney = city.money();
         for (const auto& slot : district) {
             std::cout << "Parcel: ";
             slot.show(std::cout);
@@ -131,7 +141,8 @@ int main() {
                 slot.upgradeSlot(districtMaterials, localMoney);
             }
         }
-        city.setMoney(localMoney);
+        city.transfer(localMoney - city.money(),
+                      localMoney > city.money() ? Account::UpgradeIncome : Account::UpgradeExpense, "district upgrades");
 
         //  adaugam cladirile in oras
         std::cout << "\n--- COMMIT DISTRICT INTO CITY ---\n";
@@ -141,12 +152,19 @@ int main() {
                 city.addBuildingDirect(slot.building()->clone_shared());
             }
         }
-        city.upgradeAllBuildings();
+        city.scheduleConstruction("residential", "TowerB", {"8", "1", "15"}, 1, 2);
+        city.populateCitizens();
+        city.enableEvents(EventConfig{}, 2024);
+        AutoSaver autosave("autosave.txt", 2);
+        for (int t = 0; t < 3; ++t) {
+            city.tick();
+            autosave.onTick(city);
+        }
+        autosave.flush();
+        std::cout << "\n--- CHANGES IN LAST TICK ---\n";
+        city.printChanges(city.currentTick());
         city.upgradeResidentialOnly();
-
-        ResourcePool<long> ledger;
-        ledger.add("tax_collected", 100L);
-        ledger.add("maintenance_paid", 40L);
+        city.commitLedger();
 
         long reportBudget = 5000;
         (void)trySpend(reportBudget, 200L);
@@ -154,8 +172,159 @@ int main() {
         std::cout << "\n--- CITY STATE AFTER GAMEPLAY ---\n";
         city.printSummary();
         std::cout << "Total capacity: " << city.totalCapacity() << "\n";
-        std::cout << "Ledger tax_collected=" << ledger.get("tax_collected")
-                  << ", maintenance_paid=" << ledger.get("maintenance_paid") << "\n";
+        SeriesSummary moneyHistory = city.metrics().money().range(1, city.currentTick());
+        std::cout << "Money over " << moneyHistory.count << " ticks: min=" << moneyHistory.min
+                  << ", max=" << moneyHistory.max << ", ema=" << city.metrics().money().ema() << "\n";
+        std::cout << "Citizens: " << city.citizens().size() << " (employed=" << city.citizens().employed()
+                  << ", satisfaction=" << city.citizens().averageSatisfaction() << ")\n";
+        const EventStats& ev = city.events()->stats();
+        std::cout << "Events: outages=" << ev.outages << ", repairs=" << ev.repairs << ", demand shifts="
+                  << ev.demandShifts << ", price shocks=" << ev.priceShocks << "\n";
+        std::cout << "Autosaved " << autosave.saved() << " time(s), last at tick " << autosave.lastSavedTick() << "\n";
+        {
+            // salvarea se citeste inapoi: orasul refacut scrie acelasi snapshot ca originalul
+            std::stringstream saved;
+            writeSnapshot(saved, city.snapshot());
+            const CitySnapshot before = city.snapshot();
+            const CitySnapshot after = City::restore(readSnapshot(saved)).snapshot();
+            bool streetsMatch = before.streets.size() == after.streets.size();
+            for (std::size_t i = 0; streetsMatch && i < before.streets.size(); ++i) {
+                const Street& a = before.streets[i];
+                const Street& b = after.streets[i];
+                streetsMatch = a.level() == b.level() && a.length() == b.length();
+                for (int s = 0; streetsMatch && s < a.length(); ++s)
+                    streetsMatch = a.segment(static_cast<std::size_t>(s)) == b.segment(static_cast<std::size_t>(s));
+            }
+            bool buildingsMatch = before.buildings.size() == after.buildings.size() && before.buildingStreets == after.buildingStreets;
+            for (std::size_t i = 0; buildingsMatch && i < before.buildings.size(); ++i)
+                buildingsMatch = *before.buildings[i] == *after.buildings[i];
+            std::ifstream savedFile("autosave.txt");
+            const CitySnapshot fromDisk = readSnapshot(savedFile);
+            std::cout << "Save round trip: money " << (before.money == after.money ? "ok" : "differs")
+                      << ", resources " << (before.resources == after.resources && before.produced == after.produced ? "ok" : "differ")
+                      << ", streets " << (streetsMatch ? "ok" : "differ") << ", buildings " << (buildingsMatch ? "ok" : "differ")
+                      << "; autosave file has " << fromDisk.buildings.size() << " buildings, money=" << fromDisk.money << "\n";
+        }
+        const CityMemory mem = city.memoryUsage();
+        std::cout << "Memory: total=" << mem.total() << " bytes (";
+        for (std::size_t k = 0; k < mem.buildings.size(); ++k)
+            std::cout << kindName(static_cast<BuildingKind>(k)) << "=" << mem.buildings[k] << ", ";
+        std::cout << "streets=" << mem.streets << ", names=" << mem.names << ", stats=" << mem.stats
+                  << ", citizens=" << mem.citizens << ", scheduling=" << mem.scheduling << ")\n";
+        std::cout << "Capacity below max level, by street and type:\n";
+        auto rows = BuildingQuery()
+            .where(Column::Level, CompareOp::Lt, Column::MaxLevel)
+            .groupBy(GroupStreet | GroupKind)
+            .aggregate(Column::Capacity)
+            .run(city.columns());
+        for (const auto& r : rows)
+            std::cout << "  street " << r.street << ", " << kindName(static_cast<BuildingKind>(r.kind))
+                      << ": count=" << r.count << ", capacity=" << r.sum << "\n";
+        const Ledger& ledger = city.ledger();
+        std::cout << "Ledger (" << ledger.committed() << " entries):";
+        for (std::size_t a = 0; a < ACCOUNT_COUNT; ++a)
+            std::cout << " " << accountName(static_cast<Account>(a)) << "=" << ledger.balance(static_cast<Account>(a));
+        std::cout << "\n";
+        std::ifstream ledgerLog("ledger.log");
+        LedgerFilter factoryFilter;
+        factoryFilter.account = Account::FactoryExpense;
+        Money factorySpend = 0;
+        const auto factoryEntries = auditLedger(ledgerLog, factoryFilter);
+        for (const auto& e : factoryEntries) factorySpend += e.amount;
+        std::cout << "Factory spending from log: " << factorySpend << " in " << factoryEntries.size() << " entries\n";
+        // memo-urile cu spatii trec prin jurnal si se regasesc dupa textul lor
+        ledgerLog.clear();
+        ledgerLog.seekg(0);
+        LedgerFilter districtFilter;
+        districtFilter.memo = "district upgrades";
+        const auto districtEntries = auditLedger(ledgerLog, districtFilter);
+        const bool memoRoundTrip = !districtEntries.empty() && *districtEntries.front().memo == districtFilter.memo;
+        std::cout << "District upgrades from log: " << districtEntries.size() << " entries, "
+                  << (districtEntries.empty() ? 0 : districtEntries.front().amount) << " moved, memo "
+                  << (memoRoundTrip ? "ok" : "mismatch") << "\n";
+
+        EnsemblePolicy subsidized;
+        subsidized.name = "subsidy";
+        subsidized.subsidy = 200;
+        const auto outcomes = EnsembleRunner(200, 12, 7).addPolicy({}).addPolicy(subsidized).run(city);
+        for (const auto& s : outcomes)
+            std::cout << "Ensemble " << s.policy << " (" << s.replicas << " replicas, 12 ticks): money p5/p50/p95="
+                      << s.moneyP05 << "/" << s.moneyP50 << "/" << s.moneyP95 << ", shortfall rate=" << s.shortfallRate
+                      << ", mean capacity=" << s.meanCapacity << "\n";
+
+        // demolari si reconstructii la fiecare tick: golurile sunt compactate, lista nu creste
+        City churn(city);
+        churn.setMetricsEnabled(false);
+        churn.setErrorHandler([](const Building&, const CityException&) {});
+        const std::size_t indexBefore = churn.memoryUsage().buildingIndex;
+        for (int t = 0; t < 100; ++t) {
+            const BuildingId oldest = churn.buildingIds().front();
+            const std::size_t street = churn.placement(oldest).street;
+            churn.demolishBuilding(oldest);
+            churn.addBuilding("residential", "Infill", {"5", "1", "10"}, street);
+            churn.tick();
+        }
+        std::cout << "Churn (100 ticks): buildings=" << churn.buildingTotal() << ", index memory "
+                  << indexBefore << " -> " << churn.memoryUsage().buildingIndex << " bytes\n";
+
+        // o constructie anulata inainte de termen: lucrarea dispare, slotul revine, id-ul expira
+        const int slotsBefore = churn.remainingSlots();
+        const std::size_t jobsBefore = churn.pendingJobs();
+        std::size_t annexStreet = 0;
+        while (churn.getStreet(annexStreet)->freeSlots() == 0) ++annexStreet;
+        const BuildingId annex = churn.scheduleConstruction("residential", "Annex", {"5", "1", "10"}, annexStreet, 5);
+        const std::size_t jobsScheduled = churn.pendingJobs();
+        const int slotsScheduled = churn.remainingSlots();
+        churn.demolishBuilding(annex);
+        bool staleRejected = false;
+        try {
+            churn.demolishBuilding(annex);
+        } catch (const InvalidIndexException&) {
+            staleRejected = true;
+        }
+        for (int t = 0; t < 6; ++t) churn.tick();
+        std::cout << "Cancelled construction: pending jobs " << jobsBefore << " -> " << jobsScheduled << " -> " << churn.pendingJobs()
+                  << ", free slots " << slotsBefore << " -> " << slotsScheduled << " -> " << churn.remainingSlots()
+                  << ", stale id " << (staleRejected ? "rejected" : "accepted")
+                  << ", buildings=" << churn.buildingTotal() << "\n";
+
+        // strada 0 trece de vechea limita de 10 segmente, strada 1 primeste benzi in plus
+        const Money upkeepBefore = city.upkeep();
+        for (int seg = 0; seg < 12; ++seg) city.extendStreet(0, seg + 1);
+        city.widenStreet(1);
+        std::cout << "Roads: street 0 length=" << city.getStreet(0)->length() << ", street 1 " << city.getStreet(1)->roadType()
+                  << ", MaxBuildings=" << city.maxBuildings() << ", RemainingSlots=" << city.remainingSlots()
+                  << ", upkeep " << upkeepBefore << " -> " << city.upkeep() << " per tick\n";
+
+        // un catalog nou schimba doar implicitele pentru utilitati, parcuri si fabrici:
+        // cladirile existente isi pastreaza valorile primite la creare, cele noi le iau pe cele noi
+        City tuned(city);
+        tuned.setErrorHandler([](const Building&, const CityException&) {});
+        tuned.setMoney(1000);
+        const BuildingId oldPark = tuned.addBuilding("park", "OldPark", {}, 0);
+        std::map<std::uint64_t, std::vector<std::string>> keptParams;
+        for (const BuildingId id : tuned.buildingIds()) {
+            const Building* b = tuned.building(id);
+            if (dynamic_cast<const UtilityBuilding*>(b) || dynamic_cast<const Park*>(b) || dynamic_cast<const FactoryBuilding*>(b))
+                keptParams[id.key()] = b->saveParams();
+        }
+        std::istringstream changed("CATALOG\nutility coverage 150\nutility upgrade_cost 70\npark boost 15\npark cost 45\n"
+                                   "factory amount 9\nfactory cost 35\n");
+        BuildingCatalog::instance().load(changed);
+        tuned.applyCatalog();   // ce face tick-ul dupa o reincarcare, fara upgrade-urile care schimba nivelul
+        std::size_t kept = 0;
+        for (const BuildingId id : tuned.buildingIds())
+            if (keptParams.contains(id.key()) && tuned.building(id)->saveParams() == keptParams[id.key()]) ++kept;
+        const BuildingId newPark = tuned.addBuilding("park", "NewPark", {}, 0);
+        std::cout << "Catalog reload: " << kept << "/" << keptParams.size() << " utility/park/factory buildings kept their values, park cost "
+                  << dynamic_cast<const Park*>(tuned.building(oldPark))->cost() << " (existing) vs "
+                  << dynamic_cast<const Park*>(tuned.building(newPark))->cost() << " (new)\n";
+        if (std::filesystem::exists("catalog.txt")) {
+            BuildingCatalog::instance().load("catalog.txt");
+        } else {
+            std::istringstream defaults("CATALOG\n");
+            BuildingCatalog::instance().load(defaults);
+        }
     }
     catch (const CityException& e) {
         std::cout << "City error: " << e.what() << "\n";
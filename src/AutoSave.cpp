@@ -0,0 +1,248 @@
+#include "../include/AutoSave.hpp"
+#include "../include/BuildingQuery.hpp"
+#include "../include/City.hpp"
+#include "../include/Exceptions.hpp"
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define AUTOSAVE_POSIX 1
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+void expectTag(std::istream& in, const char* tag) {
+    std::string t;
+    if (!(in >> t) || t != tag) throw CityException(std::string("Save file: was expecting ") + tag);
+}
+
+template <typename T>
+T readValue(std::istream& in, const char* what) {
+    T v{};
+    if (!(in >> v)) throw CityException(std::string("Save file: invalid ") + what);
+    return v;
+}
+
+std::size_t readCount(std::istream& in, const char* what) {
+    const long long n = readValue<long long>(in, what);
+    if (n < 0) throw CityException(std::string("Save file: negative count for ") + what);
+    return static_cast<std::size_t>(n);
+}
+
+#ifdef AUTOSAVE_POSIX
+// continutul (sau intrarea din director) ajunge pe disc inainte sa ne bazam pe el
+void syncPath(const std::string& path, int flags) {
+    const int fd = ::open(path.c_str(), flags);
+    if (fd < 0) throw CityException("Cannot open for sync: " + path);
+    const int rc = ::fsync(fd);
+    ::close(fd);
+    if (rc != 0) throw CityException("Cannot sync autosave: " + path);
+}
+#endif
+
+}
+
+void writeSnapshot(std::ostream& os, const CitySnapshot& snap) {
+    os << "CITY\n" << snap.name << ' ' << snap.money << "\n\n";
+
+    os << "STREETS\n" << snap.streets.size() << '\n';
+    for (const auto& st : snap.streets) {
+        os << "STREET\n" << st.level() << ' ' << st.length() << '\n';
+        for (int i = 0; i < st.length(); ++i) os << (i ? " " : "") << st.segment(static_cast<std::size_t>(i));
+        os << '\n';
+    }
+
+    os << "\nRESOURCES\n" << snap.resources.size() << '\n';
+    for (const auto& [name, qty] : snap.resources) os << "RESOURCE\n" << name << ' ' << qty << '\n';
+
+    os << "\nPRODUCED\n" << snap.produced.size() << '\n';
+    for (const auto& [name, qty] : snap.produced) os << "STAT\n" << name << ' ' << qty << '\n';
+
+    os << "\nBUILDINGS\n" << snap.buildings.size() << '\n';
+    for (std::size_t i = 0; i < snap.buildings.size(); ++i) {
+        const BuildingRecord& b = *snap.buildings[i];
+        os << "BUILDING\n" << b.kind << ' ' << b.name << ' ' << snap.buildingStreets[i] << ' ' << b.params.size() << '\n';
+        const char* sep = "";
+        for (const auto& p : b.params) {
+            os << sep << p;
+            sep = " ";
+        }
+        os << '\n';
+    }
+}
+
+CitySnapshot readSnapshot(std::istream& in) {
+    CitySnapshot snap;
+    expectTag(in, "CITY");
+    snap.name = readValue<std::string>(in, "city name");
+    snap.money = readValue<Money>(in, "city money");
+
+    expectTag(in, "STREETS");
+    const std::size_t streets = readCount(in, "STREETS");
+    for (std::size_t i = 0; i < streets; ++i) {
+        expectTag(in, "STREET");
+        Street st(readValue<int>(in, "street level"));
+        const std::size_t length = readCount(in, "street segments");
+        for (std::size_t j = 0; j < length; ++j)
+            if (!st.addSegment(readValue<int>(in, "street segment"))) throw LimitExceededException();
+        snap.streets.push_back(std::move(st));
+    }
+
+    expectTag(in, "RESOURCES");
+    const std::size_t resources = readCount(in, "RESOURCES");
+    for (std::size_t i = 0; i < resources; ++i) {
+        expectTag(in, "RESOURCE");
+        std::string name = readValue<std::string>(in, "resource name");
+        snap.resources[name] = readValue<int>(in, "resource quantity");
+    }
+
+    expectTag(in, "PRODUCED");
+    const std::size_t produced = readCount(in, "PRODUCED");
+    for (std::size_t i = 0; i < produced; ++i) {
+        expectTag(in, "STAT");
+        std::string name = readValue<std::string>(in, "stat name");
+        snap.produced[name] = readValue<long>(in, "stat value");
+    }
+
+    expectTag(in, "BUILDINGS");
+    const std::size_t buildings = readCount(in, "BUILDINGS");
+    snap.buildings.reserve(buildings);
+    snap.buildingStreets.reserve(buildings);
+    for (std::size_t i = 0; i < buildings; ++i) {
+        expectTag(in, "BUILDING");
+        BuildingRecord rec;
+        rec.kind = readValue<std::string>(in, "building kind");
+        rec.name = readValue<std::string>(in, "building name");
+        snap.buildingStreets.push_back(readCount(in, "building street"));
+        rec.params.resize(readCount(in, "building parameters"));
+        for (auto& p : rec.params) p = readValue<std::string>(in, "building parameter");
+        snap.buildings.push_back(std::make_shared<const BuildingRecord>(std::move(rec)));
+    }
+    return snap;
+}
+
+AutoSaver::AutoSaver(std::string path, std::uint64_t interval)
+    : path_(std::move(path)), interval_(interval), worker_(&AutoSaver::run, this) {}
+
+// snapshot-ul ramas in asteptare e scris inainte de oprire
+AutoSaver::~AutoSaver() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    worker_.join();
+}
+
+void AutoSaver::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        cv_.wait(lock, [this] { return stop_ || pending_.has_value(); });
+        if (!pending_) return;
+        CitySnapshot snap = std::move(*pending_);
+        pending_.reset();
+        writing_ = true;
+        lock.unlock();
+
+        std::exception_ptr err;
+        try {
+            writeFile(snap);
+        } catch (...) {
+            err = std::current_exception();
+        }
+        const std::uint64_t tick = snap.tick;
+        snap = CitySnapshot{};   // inregistrarile se elibereaza in afara lacatului
+
+        lock.lock();
+        writing_ = false;
+        if (err) {
+            error_ = err;
+        } else {
+            ++saved_;
+            lastSavedTick_ = tick;
+        }
+        cv_.notify_all();
+    }
+}
+
+// fisierul vechi ramane intact pana cand cel nou e complet scris
+void AutoSaver::writeFile(const CitySnapshot& snap) const {
+    const std::string tmp = path_ + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        if (!out) throw CityException("Cannot open autosave file: " + tmp);
+        writeSnapshot(out, snap);
+        out.close();
+        if (!out) throw CityException("Cannot write autosave file: " + tmp);
+    }
+#ifdef AUTOSAVE_POSIX
+    syncPath(tmp, O_RDONLY);
+#endif
+    std::error_code ec;
+    std::filesystem::rename(tmp, path_, ec);
+    if (ec) throw CityException("Cannot replace autosave file " + path_ + ": " + ec.message());
+#ifdef AUTOSAVE_POSIX
+    const std::filesystem::path dir = std::filesystem::path(path_).parent_path();
+    syncPath(dir.empty() ? std::string(".") : dir.string(), O_RDONLY | O_DIRECTORY);
+#endif
+}
+
+// erorile firului de fundal sunt raportate pe firul simularii; apelantul tine lacatul
+void AutoSaver::rethrowError() {
+    if (error_) std::rethrow_exception(std::exchange(error_, nullptr));
+}
+
+void AutoSaver::onTick(const City& city) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rethrowError();
+        if (interval_ == 0 || city.currentTick() % interval_ != 0) return;
+        if (pending_) {
+            ++skipped_;
+            return;
+        }
+    }
+    CitySnapshot snap = city.snapshot();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_ = std::move(snap);
+    }
+    cv_.notify_all();
+}
+
+// salvare ceruta explicit: inlocuieste snapshot-ul aflat inca in asteptare
+void AutoSaver::saveNow(const City& city) {
+    CitySnapshot snap = city.snapshot();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rethrowError();
+        if (pending_) ++skipped_;
+        pending_ = std::move(snap);
+    }
+    cv_.notify_all();
+}
+
+void AutoSaver::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return !pending_ && !writing_; });
+    rethrowError();
+}
+
+std::uint64_t AutoSaver::saved() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return saved_;
+}
+
+std::uint64_t AutoSaver::skipped() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return skipped_;
+}
+
+std::uint64_t AutoSaver::lastSavedTick() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lastSavedTick_;
+}
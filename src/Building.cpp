@@ -1,17 +1,39 @@
 #include "../include/Building.hpp"
 #include "../include/Street.hpp"
 #include "../include/Exceptions.hpp"
+#include "../include/BuildingCatalog.hpp"
 #include "../include/BuildingVisitor.hpp"
 #include "../include/Factory.hpp"
+#include "../include/MemoryUsage.hpp"
+#include "../include/NamePool.hpp"
+#include <charconv>
+
+namespace {
+
+// cea mai scurta reprezentare care se citeste inapoi exact cu stod
+std::string formatNumber(double v) {
+    char buf[32];
+    auto [ptr, ec] = std::to_chars(buf, buf + sizeof(buf), v);
+    return ec == std::errc{} ? std::string(buf, ptr) : std::to_string(v);
+}
+
+}
 
 void ResidentialBuilding::accept(BuildingVisitor& v) { v.visit(*this); }
 void UtilityBuilding::accept(BuildingVisitor& v) { v.visit(*this); }
 void Park::accept(BuildingVisitor& v) { v.visit(*this); }
 void CommercialBuilding::accept(BuildingVisitor& v) { v.visit(*this); }
-int Building::buildingCount_ = 0;
+std::atomic<int> Building::buildingCount_{0};
 
 // constructor baza pentru cladire
-Building::Building(std::string name, int lvl, int maxL) : name_(std::move(name)), level_(std::max(1, std::min(maxL, lvl))),maxLevel_(maxL) {
+Building::Building(std::string_view name, int lvl, int maxL, const Street* st) : name_(NamePool::instance().intern(name)), street_(st), level_(std::max(1, std::min(maxL, lvl))),maxLevel_(maxL) {
+    ++buildingCount_;
+}
+
+// clonele sunt cladiri in plus: destructorul lor decrementeaza contorul
+Building::Building(const Building& other)
+    : name_(other.name_), street_(other.street_), level_(other.level_), maxLevel_(other.maxLevel_), upgradeTicks_(other.upgradeTicks_),
+      upgrading_(other.upgrading_), upgradeDue_(other.upgradeDue_), revision_(other.revision_) {
     ++buildingCount_;
 }
 
@@ -24,6 +46,18 @@ void Building::print(std::ostream& os) const {
     printImpl(os);
 }
 
+void Building::bindStreet(const Street* st) noexcept {
+    street_ = st;
+}
+
+std::uint64_t Building::revision() const noexcept {
+    return revision_;
+}
+
+void Building::touch() noexcept {
+    ++revision_;
+}
+
 // operator << pentru afisare
 std::ostream& operator<<(std::ostream& os, const Building& b) {
     b.print(os);
@@ -31,6 +65,10 @@ std::ostream& operator<<(std::ostream& os, const Building& b) {
 }
 
 const std::string& Building::name() const noexcept {
+    return *name_;
+}
+
+const NameRef& Building::nameRef() const noexcept {
     return name_;
 }
 
@@ -38,6 +76,57 @@ int Building::level() const noexcept {
     return level_;
 }
 
+int Building::maxLevel() const noexcept {
+    return maxLevel_;
+}
+
+bool Building::isMaxed() const noexcept {
+    return level_ >= maxLevel_;
+}
+
+bool Building::isUpgrading() const noexcept {
+    return upgrading_;
+}
+
+int Building::upgradeTicks() const noexcept {
+    return upgradeTicks_;
+}
+
+void Building::setUpgradeTicks(int ticks) {
+    if (ticks < 0) throw CityException("Upgrade duration must be non-negative");
+    upgradeTicks_ = ticks;
+}
+
+std::uint64_t Building::upgradeDue() const noexcept {
+    return upgradeDue_;
+}
+
+void Building::setUpgradeDue(std::uint64_t tick) noexcept {
+    upgradeDue_ = tick;
+    touch();
+}
+
+// costul e platit in upgrade(); nivelul creste acum sau la finalul lucrarilor
+void Building::raiseLevel() noexcept {
+    if (upgradeTicks_ == 0) ++level_;
+    else upgrading_ = true;
+    touch();
+}
+
+void Building::finishUpgrade() noexcept {
+    if (!upgrading_) return;
+    upgrading_ = false;
+    upgradeDue_ = 0;
+    if (level_ < maxLevel_) ++level_;
+    touch();
+}
+
+void Building::cancelUpgrade() noexcept {
+    upgrading_ = false;
+    upgradeDue_ = 0;
+    touch();
+}
+
 int Building::buildingCount() noexcept {
     return buildingCount_;
 }
@@ -53,40 +142,42 @@ void BuildingCreator::registerCreator(const std::string& id, Creator c) {
 }
 
 // creaza cladire din registru dupa id
-std::shared_ptr<Building> BuildingCreator::create( const std::string& id, const std::string& name, const std::vector<std::string>& params,Street* street) const {
+std::shared_ptr<Building> BuildingCreator::create( const std::string& id, const std::string& name, const std::vector<std::string>& params,const Street* street) const {
     auto it = registry_.find(id);
     if (it == registry_.end())
         throw CityException("Unknown building type: " + id);
     return it->second(name, params, street);
 }
 
-ResidentialBuilding::ResidentialBuilding( const std::string& n, int cap, int lvl, const std::map<std::string,int>& resNeeded, int moneyPerUpgrade, Street* st)
-    : Building(n, lvl, 3), capacityBase_(cap), resourcesNeeded_(resNeeded), moneyProducedPerUpgrade_(moneyPerUpgrade), street_(st) {
+ResidentialBuilding::ResidentialBuilding( const std::string& n, int cap, int lvl, std::shared_ptr<const ResidentialTuning> tuning, int moneyPerUpgrade, const Street* st)
+    : Building(n, lvl, 3, st), capacityBase_(cap), tuning_(std::move(tuning)), moneyProducedPerUpgrade_(moneyPerUpgrade) {
     if (capacityBase_ <= 0)
         throw CityException("Residential must have positive base capacity");
+    if (!tuning_)
+        throw CityException("Residential needs catalog values");
 }
 
 // afisare informatii cladire rezidentiala
 void ResidentialBuilding::printImpl(std::ostream& os) const {
-    os << "Residential(name=" << name_ << ", level=" << level_ << ", capacity=" << capacityEffect() << ")";
+    os << "Residential(name=" << *name_ << ", level=" << level_ << ", capacity=" << capacityEffect() << ")";
     if (street_) {
         os << " [street level=" << street_->level() << ", segments=" << street_->length() << "]";
     }
 }
 
 // upgrade – consuma resurse si produce bani
-void ResidentialBuilding::upgrade(ResourcePool<int>& cityResources, int& money) {
-    if (level_ >= maxLevel_) return;
+void ResidentialBuilding::upgrade(ResourcePool<int>& cityResources, Money& money) {
+    if (level_ >= maxLevel_ || upgrading_) return;
 
-    for (const auto& kv : resourcesNeeded_) {
+    for (const auto& kv : tuning_->upgradeResources) {
         if (cityResources.get(kv.first) < kv.second)
             throw InsufficientResourceException(kv.first);
     }
-    for (const auto& kv : resourcesNeeded_) {
+    for (const auto& kv : tuning_->upgradeResources) {
         cityResources.consume(kv.first, kv.second);
     }
 
-    ++level_;
+    raiseLevel();
     money += moneyProducedPerUpgrade_;
 }
 
@@ -101,6 +192,19 @@ int ResidentialBuilding::capacityEffect() const {
     return capacityBase_ * level_;
 }
 
+std::vector<std::string> ResidentialBuilding::saveParams() const {
+    return {std::to_string(capacityBase_), std::to_string(level_), std::to_string(moneyProducedPerUpgrade_)};
+}
+
+// tabela catalogului e partajata de toate cladirile de acelasi tip
+std::size_t ResidentialBuilding::memoryUsage() const {
+    return sizeof(*this);
+}
+
+void ResidentialBuilding::bindCatalog(const CatalogTables& tables) {
+    tuning_ = tables.residential;
+}
+
 
 UtilityBuilding::UtilityBuilding(
     const std::string& n,
@@ -108,26 +212,25 @@ UtilityBuilding::UtilityBuilding(
     double cov,
     int lvl,
     int moneyCost,
-    Street* st)
-    : Building(n, lvl, 3),
+    const Street* st)
+    : Building(n, lvl, 3, st),
       coverage_(cov),
       moneyCostPerUpgrade_(moneyCost),
-      type_(std::move(t)),
-      street_(st) {}
+      type_(std::move(t)) {}
 
 void UtilityBuilding::printImpl(std::ostream& os) const {
-    os << "Utility(name=" << name_ << ", type=" << type_ << ", level=" << level_ << ")";
+    os << "Utility(name=" << *name_ << ", type=" << type_ << ", level=" << level_ << ")";
     if (street_) {
         os << " [street level=" << street_->level() << ", segments=" << street_->length() << "]";
     }
 }
 
-void UtilityBuilding::upgrade(ResourcePool<int>&, int& money) {
-    if (level_ >= maxLevel_) return;
+void UtilityBuilding::upgrade(ResourcePool<int>&, Money& money) {
+    if (level_ >= maxLevel_ || upgrading_) return;
     if (money < moneyCostPerUpgrade_)
         throw CityException("Not enough money to upgrade utility");
     money -= moneyCostPerUpgrade_;
-    ++level_;
+    raiseLevel();
 }
 
 // clona polimorfa
@@ -137,25 +240,50 @@ std::shared_ptr<Building> UtilityBuilding::clone_shared() const {
 
 // efect asupra capacitatii
 int UtilityBuilding::capacityEffect() const {
-    return static_cast<int>(coverage_) * level_;
+    return isOffline() ? 0 : static_cast<int>(coverage_) * level_;
+}
+
+void UtilityBuilding::startOutage(std::uint64_t until) noexcept {
+    outageUntil_ = until;
+    touch();
+}
+
+void UtilityBuilding::endOutage() noexcept {
+    outageUntil_ = 0;
+    touch();
+}
+
+bool UtilityBuilding::isOffline() const noexcept {
+    return outageUntil_ != 0;
+}
+
+std::uint64_t UtilityBuilding::outageUntil() const noexcept {
+    return outageUntil_;
+}
+
+std::vector<std::string> UtilityBuilding::saveParams() const {
+    return {type_, formatNumber(coverage_), std::to_string(level_), std::to_string(moneyCostPerUpgrade_)};
+}
+
+std::size_t UtilityBuilding::memoryUsage() const {
+    return sizeof(*this) + stringHeap(type_);
 }
 
-Park::Park(const std::string& n, double boost, int cost, Street* st)
-    : Building(n, 1, 2),
+Park::Park(const std::string& n, double boost, int cost, const Street* st, int lvl)
+    : Building(n, lvl, 2, st),
       populationBoost_(boost),
-      moneyCost_(cost),
-      street_(st) {}
+      moneyCost_(cost) {}
 
 // afisare parc
 void Park::printImpl(std::ostream& os) const {
-    os << "Park(name=" << name_ << ", level=" << level_ << ", boost=" << populationBoost_ << ")";
+    os << "Park(name=" << *name_ << ", level=" << level_ << ", boost=" << populationBoost_ << ")";
     if (street_) {
         os << " [street level=" << street_->level() << ", segments=" << street_->length() << "]";
     }
 }
 
-void Park::upgrade(ResourcePool<int>&, int&) {
-    if (level_ < maxLevel_) ++level_;
+void Park::upgrade(ResourcePool<int>&, Money&) {
+    if (level_ < maxLevel_ && !upgrading_) raiseLevel();
 }
 
 // clona polimorfa
@@ -166,6 +294,14 @@ int Park::capacityEffect() const {
     return static_cast<int>(populationBoost_) * level_;
 }
 
+std::vector<std::string> Park::saveParams() const {
+    return {formatNumber(populationBoost_), std::to_string(moneyCost_), std::to_string(level_)};
+}
+
+std::size_t Park::memoryUsage() const {
+    return sizeof(*this);
+}
+
 // cost de constructie
 int Park::cost() const noexcept {
     return moneyCost_;
@@ -176,30 +312,34 @@ CommercialBuilding::CommercialBuilding(
     const std::string& n,
     int baseCustomers,
     int lvl,
-    Street* st)
-    : Building(n, lvl, 4),
+    std::shared_ptr<const CommercialTuning> tuning,
+    const Street* st)
+    : Building(n, lvl, 4, st),
       customersPerLevel_(baseCustomers),
-      street_(st) {
+      tuning_(std::move(tuning)) {
 
     if (baseCustomers < 0)
         throw CityException("Commercial base customers must be non-negative");
+    if (!tuning_)
+        throw CityException("Commercial needs catalog values");
 }
 
 // afisare cladire comerciala
 void CommercialBuilding::printImpl(std::ostream& os) const {
-    os << "Commercial(name=" << name_ << ", level=" << level_ << ")";
+    os << "Commercial(name=" << *name_ << ", level=" << level_ << ")";
     if (street_) {
         os << " [street level=" << street_->level() << ", segments=" << street_->length() << "]";
     }
 }
 
 // upgrade – cost fix in functie de nivel
-void CommercialBuilding::upgrade(ResourcePool<int>&, int& money) {
-    int cost = 20 * level_;
+void CommercialBuilding::upgrade(ResourcePool<int>&, Money& money) {
+    if (level_ >= maxLevel_ || upgrading_) return;
+    int cost = tuning_->upgradeCostPerLevel * level_;
     if (money < cost)
         throw CityException("Not enough money to upgrade commercial building");
     money -= cost;
-    ++level_;
+    raiseLevel();
 }
 
 // clona polimorfa
@@ -209,7 +349,35 @@ std::shared_ptr<Building> CommercialBuilding::clone_shared() const {
 
 // capacitate = clienti per nivel * nivel
 int CommercialBuilding::capacityEffect() const {
-    return customersPerLevel_ * level_;
+    const int base = customersPerLevel_ * level_;
+    return demand_ == 1.0 ? base : static_cast<int>(base * demand_);
+}
+
+// until = 0 readuce cererea la normal
+void CommercialBuilding::setDemand(double demand, std::uint64_t until) noexcept {
+    demand_ = until == 0 ? 1.0 : demand;
+    demandUntil_ = until;
+    touch();
+}
+
+double CommercialBuilding::demand() const noexcept {
+    return demand_;
+}
+
+std::uint64_t CommercialBuilding::demandUntil() const noexcept {
+    return demandUntil_;
+}
+
+std::vector<std::string> CommercialBuilding::saveParams() const {
+    return {std::to_string(customersPerLevel_), std::to_string(level_)};
+}
+
+std::size_t CommercialBuilding::memoryUsage() const {
+    return sizeof(*this);
+}
+
+void CommercialBuilding::bindCatalog(const CatalogTables& tables) {
+    tuning_ = tables.commercial;
 }
 
 namespace {
@@ -220,13 +388,14 @@ namespace {
     ("residential",
      [](const std::string& name,
         const std::vector<std::string>& params,
-        Street* st) -> std::shared_ptr<Building>
+        const Street* st) -> std::shared_ptr<Building>
         {
-            int cap = !params.empty() ? std::stoi(params[0]) : 10;
+            auto tables = BuildingCatalog::instance().current();
+            const ResidentialTuning& t = *tables->residential;
+            int cap = !params.empty() ? std::stoi(params[0]) : t.defaultCapacity;
             int lvl = params.size() > 1 ? std::stoi(params[1]) : 1;
-            int money = params.size() > 2 ? std::stoi(params[2]) : 20;
-            std::map<std::string,int> needed{{"wood",10},{"stone",5}};
-            return std::make_shared<ResidentialBuilding>(name, cap, lvl, needed, money, st);
+            int money = params.size() > 2 ? std::stoi(params[2]) : t.defaultMoneyPerUpgrade;
+            return std::make_shared<ResidentialBuilding>(name, cap, lvl, tables->residential, money, st);
         }
     );
     return true;
@@ -239,12 +408,14 @@ namespace {
         "utility",
         [](const std::string& name,
            const std::vector<std::string>& params,
-           Street* st) -> std::shared_ptr<Building>
+           const Street* st) -> std::shared_ptr<Building>
         {
-            std::string t = !params.empty()? params[0] : "Water";
-            double cov = params.size() > 1 ? std::stod(params[1]) : 100.0;
+            auto tables = BuildingCatalog::instance().current();
+            const UtilityTuning& tuning = *tables->utility;
+            std::string t = !params.empty()? params[0] : tuning.defaultType;
+            double cov = params.size() > 1 ? std::stod(params[1]) : tuning.defaultCoverage;
             int lvl = params.size() > 2 ? std::stoi(params[2]) : 1;
-            int cost = params.size() > 3 ? std::stoi(params[3]) : 50;
+            int cost = params.size() > 3 ? std::stoi(params[3]) : tuning.defaultUpgradeCost;
             return std::make_shared<UtilityBuilding>(name, t, cov, lvl, cost, st);
         }
     );
@@ -258,11 +429,13 @@ namespace {
         "park",
         [](const std::string& name,
            const std::vector<std::string>& params,
-           Street* st) -> std::shared_ptr<Building>
+           const Street* st) -> std::shared_ptr<Building>
         {
-            double boost = !params.empty() ? std::stod(params[0]) : 10.0;
-            int cost = params.size() > 1 ? std::stoi(params[1]) : 30;
-            return std::make_shared<Park>(name, boost, cost, st);
+            auto tables = BuildingCatalog::instance().current();
+            double boost = !params.empty() ? std::stod(params[0]) : tables->park->defaultBoost;
+            int cost = params.size() > 1 ? std::stoi(params[1]) : tables->park->defaultCost;
+            int lvl = params.size() > 2 ? std::stoi(params[2]) : 1;
+            return std::make_shared<Park>(name, boost, cost, st, lvl);
         }
     );
     return true;
@@ -272,11 +445,12 @@ namespace {
 [[maybe_unused]] const bool commercial_registered = [](){
     BuildingCreator::instance().registerCreator
     (
-        "commercial", [](const std::string& name, const std::vector<std::string>& params, Street* st) -> std::shared_ptr<Building>
+        "commercial", [](const std::string& name, const std::vector<std::string>& params, const Street* st) -> std::shared_ptr<Building>
         {
-            int baseC = !params.empty() ? std::stoi(params[0]) : 50;
+            auto tables = BuildingCatalog::instance().current();
+            int baseC = !params.empty() ? std::stoi(params[0]) : tables->commercial->defaultCustomers;
             int lvl = params.size() > 1 ? std::stoi(params[1]) : 1;
-            return std::make_shared<CommercialBuilding>(name, baseC, lvl, st);
+            return std::make_shared<CommercialBuilding>(name, baseC, lvl, tables->commercial, st);
         }
     );
     return true;
@@ -293,7 +467,7 @@ void Slot::setBuilding(std::shared_ptr<Building> b) noexcept {
 }
 
 // upgrade pornind de la pointer de baza
-void Slot::upgradeSlot(ResourcePool<int>& resources, int& money) const {
+void Slot::upgradeSlot(ResourcePool<int>& resources, Money& money) const {
     if (!building_) throw CityException("No building in slot to upgrade");
     building_->upgrade(resources, money);
 }
@@ -0,0 +1,138 @@
+#include "../include/BuildingCatalog.hpp"
+#include "../include/Exceptions.hpp"
+#include <fstream>
+#include <system_error>
+
+namespace {
+
+int readInt(std::istream& in, const std::string& entry, int min) {
+    int v = 0;
+    if (!(in >> v)) throw CityException("Invalid value for catalog entry: " + entry);
+    if (v < min) throw CityException("Value out of range for catalog entry: " + entry);
+    return v;
+}
+
+double readDouble(std::istream& in, const std::string& entry) {
+    double v = 0.0;
+    if (!(in >> v)) throw CityException("Invalid value for catalog entry: " + entry);
+    if (v < 0.0) throw CityException("Value out of range for catalog entry: " + entry);
+    return v;
+}
+
+std::string readWord(std::istream& in, const std::string& entry) {
+    std::string w;
+    if (!(in >> w)) throw CityException("Missing value for catalog entry: " + entry);
+    return w;
+}
+
+}
+
+BuildingCatalog& BuildingCatalog::instance() {
+    static BuildingCatalog inst;
+    return inst;
+}
+
+std::shared_ptr<const CatalogTables> BuildingCatalog::current() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tables_;
+}
+
+std::uint64_t BuildingCatalog::version() const noexcept {
+    return version_.load(std::memory_order_acquire);
+}
+
+// fiecare linie: <tip> <cheie> <valori>; cheile lipsa pastreaza valorile implicite
+CatalogTables BuildingCatalog::parse(std::istream& in) {
+    ResidentialTuning residential;
+    UtilityTuning utility;
+    ParkTuning park;
+    CommercialTuning commercial;
+    FactoryTuning factory;
+    bool customResources = false;
+
+    std::string tag;
+    if (!(in >> tag) || tag != "CATALOG") throw CityException("Missing section CATALOG");
+
+    std::string type, key;
+    while (in >> type) {
+        if (!(in >> key)) throw CityException("Incomplete catalog entry: " + type);
+        const std::string entry = type + " " + key;
+
+        if (entry == "residential capacity") residential.defaultCapacity = readInt(in, entry, 1);
+        else if (entry == "residential money_per_upgrade") residential.defaultMoneyPerUpgrade = readInt(in, entry, 0);
+        else if (entry == "residential upgrade_resource") {
+            // prima intrare din fisier inlocuieste lista implicita
+            if (!customResources) residential.upgradeResources.clear();
+            customResources = true;
+            std::string resName = readWord(in, entry);
+            residential.upgradeResources[resName] = readInt(in, entry, 0);
+        }
+        else if (entry == "utility type") utility.defaultType = readWord(in, entry);
+        else if (entry == "utility coverage") utility.defaultCoverage = readDouble(in, entry);
+        else if (entry == "utility upgrade_cost") utility.defaultUpgradeCost = readInt(in, entry, 0);
+        else if (entry == "park boost") park.defaultBoost = readDouble(in, entry);
+        else if (entry == "park cost") park.defaultCost = readInt(in, entry, 0);
+        else if (entry == "commercial customers") commercial.defaultCustomers = readInt(in, entry, 0);
+        else if (entry == "commercial upgrade_cost_per_level") commercial.upgradeCostPerLevel = readInt(in, entry, 0);
+        else if (entry == "factory resource") factory.defaultResource = readWord(in, entry);
+        else if (entry == "factory amount") factory.defaultAmount = readInt(in, entry, 1);
+        else if (entry == "factory cost") factory.defaultCost = readInt(in, entry, 1);
+        else throw CityException("Unknown catalog entry: " + entry);
+    }
+
+    CatalogTables t;
+    t.residential = std::make_shared<const ResidentialTuning>(std::move(residential));
+    t.utility = std::make_shared<const UtilityTuning>(std::move(utility));
+    t.park = std::make_shared<const ParkTuning>(park);
+    t.commercial = std::make_shared<const CommercialTuning>(commercial);
+    t.factory = std::make_shared<const FactoryTuning>(std::move(factory));
+    return t;
+}
+
+// stampila se citeste inainte de parsare: o scriere facuta in timpul parsarii o schimba
+// din nou, deci urmatorul reloadIfChanged incarca si versiunea aceea
+void BuildingCatalog::load(const std::string& path) {
+    std::error_code ec;
+    const auto stamp = std::filesystem::last_write_time(path, ec);
+    std::ifstream in(path);
+    if (!in) throw CityException("Cannot open catalog: " + path);
+    auto tables = std::make_shared<const CatalogTables>(parse(in));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    tables_ = std::move(tables);
+    path_ = path;
+    loadedAt_ = ec ? std::filesystem::file_time_type{} : stamp;
+    version_.fetch_add(1, std::memory_order_release);
+}
+
+void BuildingCatalog::load(std::istream& in) {
+    auto tables = std::make_shared<const CatalogTables>(parse(in));
+    std::lock_guard<std::mutex> lock(mutex_);
+    tables_ = std::move(tables);
+    version_.fetch_add(1, std::memory_order_release);
+}
+
+bool BuildingCatalog::reloadIfChanged() {
+    std::string path;
+    std::filesystem::file_time_type loadedAt;
+    std::filesystem::file_time_type failedAt;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        path = path_;
+        loadedAt = loadedAt_;
+        failedAt = failedAt_;
+    }
+    if (path.empty()) return false;
+    std::error_code ec;
+    const auto stamp = std::filesystem::last_write_time(path, ec);
+    if (ec || stamp == loadedAt || stamp == failedAt) return false;
+    try {
+        load(path);
+    } catch (...) {
+        // versiunea gresita nu se mai parseaza pana cand fisierul nu se schimba din nou
+        std::lock_guard<std::mutex> lock(mutex_);
+        failedAt_ = stamp;
+        throw;
+    }
+    return true;
+}
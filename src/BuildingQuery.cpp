@@ -0,0 +1,268 @@
+#include "../include/BuildingQuery.hpp"
+#include "../include/Building.hpp"
+#include "../include/BuildingVisitor.hpp"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+
+class KindVisitor : public BuildingVisitor {
+public:
+    BuildingKind kind = BuildingKind::Residential;
+    void visit(ResidentialBuilding&) override { kind = BuildingKind::Residential; }
+    void visit(UtilityBuilding&) override     { kind = BuildingKind::Utility; }
+    void visit(Park&) override                { kind = BuildingKind::Park; }
+    void visit(CommercialBuilding&) override  { kind = BuildingKind::Commercial; }
+    void visit(FactoryBuilding&) override     { kind = BuildingKind::Factory; }
+};
+
+struct Agg {
+    std::uint64_t count = 0;
+    long long sum = 0;
+    long long min = std::numeric_limits<long long>::max();
+    long long max = std::numeric_limits<long long>::min();
+
+    void add(long long v) noexcept {
+        ++count;
+        sum += v;
+        min = std::min(min, v);
+        max = std::max(max, v);
+    }
+    void merge(const Agg& o) noexcept {
+        count += o.count;
+        sum += o.sum;
+        min = std::min(min, o.min);
+        max = std::max(max, o.max);
+    }
+};
+
+constexpr std::size_t CHUNK_ROWS = std::size_t{1} << 16;
+constexpr std::size_t DENSE_GROUPS = std::size_t{1} << 16;
+constexpr std::size_t KIND_COUNT = 5;
+
+// pointer la inceputul coloanei, cu tipul ei real
+template <typename Fn>
+void withColumn(const BuildingColumns& c, Column col, std::size_t begin, Fn&& fn) {
+    switch (col) {
+        case Column::Kind:     fn(c.kind.data() + begin); break;
+        case Column::Street:   fn(c.street.data() + begin); break;
+        case Column::Level:    fn(c.level.data() + begin); break;
+        case Column::MaxLevel: fn(c.maxLevel.data() + begin); break;
+        case Column::Capacity: fn(c.capacity.data() + begin); break;
+    }
+}
+
+template <typename Fn>
+void withOp(CompareOp op, Fn&& fn) {
+    switch (op) {
+        case CompareOp::Eq: fn(std::equal_to<>{}); break;
+        case CompareOp::Ne: fn(std::not_equal_to<>{}); break;
+        case CompareOp::Lt: fn(std::less<>{}); break;
+        case CompareOp::Le: fn(std::less_equal<>{}); break;
+        case CompareOp::Gt: fn(std::greater<>{}); break;
+        case CompareOp::Ge: fn(std::greater_equal<>{}); break;
+    }
+}
+
+// cheie compacta de grupare: tip | nivel | strada
+std::uint64_t groupKey(const BuildingColumns& c, std::size_t i, unsigned keys) noexcept {
+    std::uint64_t k = 0;
+    if (keys & GroupKind) k |= std::uint64_t{c.kind[i]} << 56;
+    if (keys & GroupLevel) k |= (static_cast<std::uint64_t>(c.level[i]) & 0xFFFFu) << 40;
+    if (keys & GroupStreet) k |= c.street[i];
+    return k;
+}
+
+}
+
+const char* kindName(BuildingKind k) noexcept {
+    switch (k) {
+        case BuildingKind::Residential: return "residential";
+        case BuildingKind::Utility: return "utility";
+        case BuildingKind::Park: return "park";
+        case BuildingKind::Commercial: return "commercial";
+        case BuildingKind::Factory: return "factory";
+    }
+    return "unknown";
+}
+
+BuildingKind kindOf(Building& b) {
+    KindVisitor v;
+    b.accept(v);
+    return v.kind;
+}
+
+void BuildingColumns::reserve(std::size_t n) {
+    kind.reserve(n);
+    street.reserve(n);
+    level.reserve(n);
+    maxLevel.reserve(n);
+    capacity.reserve(n);
+}
+
+void BuildingColumns::append(BuildingKind k, std::uint32_t st, int lvl, int maxLvl, long long cap) {
+    kind.push_back(static_cast<std::uint8_t>(k));
+    street.push_back(st);
+    level.push_back(lvl);
+    maxLevel.push_back(maxLvl);
+    capacity.push_back(cap);
+}
+
+std::size_t BuildingColumns::size() const noexcept {
+    return kind.size();
+}
+
+BuildingQuery& BuildingQuery::where(Column c, CompareOp op, long long value) {
+    where_.push_back(Predicate{c, op, false, c, value});
+    return *this;
+}
+
+BuildingQuery& BuildingQuery::where(Column lhs, CompareOp op, Column rhs) {
+    where_.push_back(Predicate{lhs, op, true, rhs, 0});
+    return *this;
+}
+
+BuildingQuery& BuildingQuery::groupBy(unsigned keys) {
+    groupBy_ |= keys;
+    return *this;
+}
+
+BuildingQuery& BuildingQuery::aggregate(Column c) {
+    value_ = c;
+    return *this;
+}
+
+// fiecare predicat e o bucla fara ramificatii peste o coloana, care restrange masca de selectie
+void BuildingQuery::filter(const BuildingColumns& c, std::size_t begin, std::size_t end, std::vector<std::uint8_t>& sel) const {
+    const std::size_t n = end - begin;
+    sel.assign(n, 1);
+    std::uint8_t* s = sel.data();
+    for (const Predicate& p : where_) {
+        withOp(p.op, [&](auto cmp) {
+            withColumn(c, p.lhs, begin, [&](const auto* l) {
+                if (!p.againstColumn) {
+                    const long long v = p.value;
+                    for (std::size_t i = 0; i < n; ++i)
+                        s[i] &= static_cast<std::uint8_t>(cmp(static_cast<long long>(l[i]), v));
+                    return;
+                }
+                withColumn(c, p.rhs, begin, [&](const auto* r) {
+                    for (std::size_t i = 0; i < n; ++i)
+                        s[i] &= static_cast<std::uint8_t>(cmp(static_cast<long long>(l[i]), static_cast<long long>(r[i])));
+                });
+            });
+        });
+    }
+}
+
+// scanare pe bucati de coloana in paralel, fiecare fir cu agregatele lui, combinate la final
+std::vector<QueryRow> BuildingQuery::run(const BuildingColumns& data, unsigned threads) const {
+    const std::size_t rows = data.size();
+    const std::size_t chunks = (rows + CHUNK_ROWS - 1) / CHUNK_ROWS;
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::clamp<std::size_t>(chunks, 1, threads));
+
+    // daca spatiul cheilor e mic, grupurile sunt un tablou dens in loc de hash
+    std::size_t streets = 1, kinds = 1, levels = 1;
+    if (groupBy_ & GroupStreet)
+        streets = rows ? static_cast<std::size_t>(*std::ranges::max_element(data.street)) + 1 : 1;
+    if (groupBy_ & GroupKind) kinds = KIND_COUNT;
+    if (groupBy_ & GroupLevel)
+        levels = rows ? static_cast<std::size_t>(std::max(0, *std::ranges::max_element(data.level))) + 1 : 1;
+    const bool dense = streets * kinds * levels <= DENSE_GROUPS
+                       && std::ranges::all_of(data.level, [](std::int32_t l) { return l >= 0; });
+
+    using Groups = std::unordered_map<std::uint64_t, Agg>;
+    std::vector<Groups> partial(threads);
+    std::vector<std::vector<Agg>> partialDense(threads);
+    std::atomic<std::size_t> nextChunk{0};
+
+    auto worker = [&](unsigned t) {
+        Groups& groups = partial[t];
+        std::vector<Agg>& table = partialDense[t];
+        if (dense) table.resize(streets * kinds * levels);
+        std::vector<std::uint8_t> sel;
+        for (std::size_t ch = nextChunk++; ch < chunks; ch = nextChunk++) {
+            const std::size_t begin = ch * CHUNK_ROWS;
+            const std::size_t end = std::min(rows, begin + CHUNK_ROWS);
+            filter(data, begin, end, sel);
+            withColumn(data, value_, begin, [&](const auto* v) {
+                if (groupBy_ == GroupNone) {
+                    Agg a;
+                    for (std::size_t i = 0; i < end - begin; ++i)
+                        if (sel[i]) a.add(static_cast<long long>(v[i]));
+                    groups[0].merge(a);
+                    return;
+                }
+                if (dense) {
+                    const bool byStreet = groupBy_ & GroupStreet, byKind = groupBy_ & GroupKind, byLevel = groupBy_ & GroupLevel;
+                    for (std::size_t i = 0; i < end - begin; ++i) {
+                        if (!sel[i]) continue;
+                        const std::size_t row = begin + i;
+                        std::size_t idx = byStreet ? data.street[row] : 0;
+                        idx = idx * kinds + (byKind ? data.kind[row] : 0);
+                        idx = idx * levels + (byLevel ? static_cast<std::size_t>(data.level[row]) : 0);
+                        table[idx].add(static_cast<long long>(v[i]));
+                    }
+                    return;
+                }
+                // cladirile vecine au de obicei aceeasi cheie, evitam cautarea in hash
+                std::uint64_t lastKey = 0;
+                Agg* last = nullptr;
+                for (std::size_t i = 0; i < end - begin; ++i) {
+                    if (!sel[i]) continue;
+                    const std::uint64_t key = groupKey(data, begin + i, groupBy_);
+                    if (!last || key != lastKey) {
+                        last = &groups[key];
+                        lastKey = key;
+                    }
+                    last->add(static_cast<long long>(v[i]));
+                }
+            });
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker, t);
+    worker(0);
+    for (auto& th : pool) th.join();
+
+    Groups merged = std::move(partial[0]);
+    for (unsigned t = 1; t < threads; ++t)
+        for (const auto& kv : partial[t]) merged[kv.first].merge(kv.second);
+    if (dense) {
+        for (std::size_t idx = 0; idx < streets * kinds * levels; ++idx) {
+            Agg a;
+            for (const auto& table : partialDense) a.merge(table[idx]);
+            if (a.count == 0) continue;
+            std::uint64_t key = 0;
+            if (groupBy_ & GroupKind) key |= std::uint64_t{(idx / levels) % kinds} << 56;
+            if (groupBy_ & GroupLevel) key |= std::uint64_t{idx % levels} << 40;
+            if (groupBy_ & GroupStreet) key |= idx / (kinds * levels);
+            merged[key].merge(a);
+        }
+    }
+
+    std::vector<std::pair<std::uint64_t, Agg>> sorted(merged.begin(), merged.end());
+    std::ranges::sort(sorted, {}, &std::pair<std::uint64_t, Agg>::first);
+
+    std::vector<QueryRow> out;
+    out.reserve(std::max<std::size_t>(sorted.size(), 1));
+    for (const auto& [key, a] : sorted) {
+        QueryRow r;
+        if (groupBy_ & GroupKind) r.kind = static_cast<int>(key >> 56);
+        if (groupBy_ & GroupLevel) r.level = static_cast<int>((key >> 40) & 0xFFFFu);
+        if (groupBy_ & GroupStreet) r.street = static_cast<long long>(key & 0xFFFFFFFFu);
+        r.count = a.count;
+        r.sum = a.sum;
+        r.min = a.count ? a.min : 0;
+        r.max = a.count ? a.max : 0;
+        out.push_back(r);
+    }
+    if (out.empty() && groupBy_ == GroupNone) out.emplace_back();
+    return out;
+}
@@ -0,0 +1,291 @@
+#include "../include/Citizens.hpp"
+#include "../include/Building.hpp"
+#include "../include/BuildingQuery.hpp"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+
+constexpr std::size_t CHUNK = std::size_t{1} << 16;
+constexpr float SERVICE_WEIGHT = 0.7f;
+constexpr float JOB_WEIGHT = 0.3f;
+constexpr float ADAPT_RATE = 0.1f;
+
+bool isWorkplace(BuildingKind k) noexcept {
+    return k == BuildingKind::Commercial || k == BuildingKind::Factory;
+}
+
+}
+
+void CitizenSystem::spawnResidents(std::uint32_t home, int count) {
+    for (int i = 0; i < count; ++i) {
+        jobless_.push_back(static_cast<std::uint32_t>(home_.size()));
+        home_.push_back(home);
+        work_.push_back(NONE);
+        satisfaction_.push_back(0.5f);
+    }
+}
+
+void CitizenSystem::matchJobs() {
+    while (!jobless_.empty() && !openJobs_.empty()) {
+        OpenJobs& j = openJobs_.back();
+        work_[jobless_.back()] = j.building;
+        jobless_.pop_back();
+        if (--j.free == 0) openJobs_.pop_back();
+    }
+}
+
+// populeaza orasul: locuitori dupa capacitatea rezidentiala, locuri de munca dupa comert si fabrici
+void CitizenSystem::rebuild(const std::vector<std::shared_ptr<Building>>& buildings, const std::vector<SlotRef>& placements, std::size_t streetCount) {
+    home_.clear();
+    work_.clear();
+    satisfaction_.clear();
+    openJobs_.clear();
+    jobless_.clear();
+    buildingStreet_.clear();
+    counted_.clear();
+    for (std::size_t i = 0; i < buildings.size(); ++i)
+        if (buildings[i]) onBuildingAdded(i, *buildings[i], placements[i]);
+    refreshServices(buildings, placements, streetCount);
+}
+
+void CitizenSystem::onBuildingAdded(std::size_t idx, Building& b, const SlotRef& ref) {
+    if (buildingStreet_.size() <= idx) buildingStreet_.resize(idx + 1, 0);
+    if (counted_.size() <= idx) counted_.resize(idx + 1, 0);
+    buildingStreet_[idx] = static_cast<std::uint32_t>(ref.street);
+
+    const BuildingKind k = kindOf(b);
+    const int cap = std::max(0, b.capacityEffect());
+    counted_[idx] = 0;
+    if (k == BuildingKind::Residential) spawnResidents(static_cast<std::uint32_t>(idx), cap);
+    else if (isWorkplace(k) && cap > 0) openJobs_.push_back({static_cast<std::uint32_t>(idx), cap});
+    else return;
+    counted_[idx] = cap;
+    matchJobs();
+}
+
+// cresterile adauga locuitori sau locuri libere; la scadere pleaca intai locurile libere, apoi
+// locuitorii si angajatii in plus, intr-o singura trecere peste cetateni
+void CitizenSystem::syncCapacity(const std::vector<std::shared_ptr<Building>>& buildings) {
+    if (counted_.size() < buildings.size()) counted_.resize(buildings.size(), 0);
+    std::unordered_map<std::uint32_t, int> retire, cut;
+    for (std::size_t i = 0; i < buildings.size(); ++i) {
+        if (!buildings[i]) continue;
+        const BuildingKind k = kindOf(*buildings[i]);
+        const bool home = k == BuildingKind::Residential;
+        if (!home && !isWorkplace(k)) continue;
+        const int cap = std::max(0, buildings[i]->capacityEffect());
+        const int delta = cap - counted_[i];
+        if (delta == 0) continue;
+        counted_[i] = cap;
+        const auto idx = static_cast<std::uint32_t>(i);
+        if (delta > 0) {
+            if (home) spawnResidents(idx, delta);
+            else openJobs_.push_back({idx, delta});
+        } else if (home) retire[idx] = -delta;
+        else cut[idx] = -delta;
+    }
+
+    for (auto& j : openJobs_) {
+        auto it = cut.find(j.building);
+        if (it == cut.end()) continue;
+        const int take = std::min(it->second, j.free);
+        j.free -= take;
+        it->second -= take;
+    }
+    std::erase_if(openJobs_, [](const OpenJobs& j) { return j.free == 0; });
+    std::erase_if(cut, [](const auto& kv) { return kv.second == 0; });
+
+    if (!retire.empty() || !cut.empty()) {
+        std::size_t keep = 0;
+        jobless_.clear();
+        std::unordered_map<std::uint32_t, int> freed;   // locuri lasate de locuitorii plecati
+        for (std::size_t i = 0; i < home_.size(); ++i) {
+            std::uint32_t w = work_[i];
+            if (auto it = retire.find(home_[i]); it != retire.end() && it->second > 0) {
+                --it->second;
+                if (w != NONE) ++freed[w];
+                continue;
+            }
+            if (w != NONE) {
+                if (auto it = cut.find(w); it != cut.end() && it->second > 0) {
+                    --it->second;
+                    w = NONE;
+                }
+            }
+            home_[keep] = home_[i];
+            work_[keep] = w;
+            satisfaction_[keep] = satisfaction_[i];
+            if (w == NONE) jobless_.push_back(static_cast<std::uint32_t>(keep));
+            ++keep;
+        }
+        home_.resize(keep);
+        work_.resize(keep);
+        satisfaction_.resize(keep);
+
+        // un loc eliberat la o cladire care trebuia sa scada acopera din scadere
+        for (auto [building, count] : freed) {
+            if (auto it = cut.find(building); it != cut.end()) {
+                const int take = std::min(count, it->second);
+                it->second -= take;
+                count -= take;
+            }
+            if (count > 0) openJobs_.push_back({building, count});
+        }
+    }
+    matchJobs();
+}
+
+// locuitorii cladirilor demolate dispar, angajatii lor raman fara loc de munca
+void CitizenSystem::removeBuildings(const std::vector<std::uint32_t>& positions) {
+    if (positions.empty()) return;
+    std::vector<bool> gone(buildingStreet_.size(), false);
+    for (std::uint32_t p : positions) {
+        if (p >= gone.size()) gone.resize(p + 1, false);
+        gone[p] = true;
+    }
+    auto isGone = [&gone](std::uint32_t b) { return b != NONE && b < gone.size() && gone[b]; };
+
+    std::size_t keep = 0;
+    jobless_.clear();
+    std::unordered_map<std::uint32_t, int> freed;   // locuri eliberate de locuitorii disparuti
+    for (std::size_t i = 0; i < home_.size(); ++i) {
+        std::uint32_t w = work_[i];
+        if (isGone(home_[i])) {
+            if (w != NONE && !isGone(w)) ++freed[w];
+            continue;
+        }
+        if (isGone(w)) w = NONE;
+        home_[keep] = home_[i];
+        work_[keep] = w;
+        satisfaction_[keep] = satisfaction_[i];
+        if (w == NONE) jobless_.push_back(static_cast<std::uint32_t>(keep));
+        ++keep;
+    }
+    home_.resize(keep);
+    work_.resize(keep);
+    satisfaction_.resize(keep);
+
+    std::erase_if(openJobs_, [&isGone](const OpenJobs& j) { return isGone(j.building); });
+    for (auto& j : openJobs_) {
+        if (auto it = freed.find(j.building); it != freed.end()) {
+            j.free += it->second;
+            freed.erase(it);
+        }
+    }
+    for (const auto& [building, count] : freed) openJobs_.push_back({building, count});
+    for (std::uint32_t p : positions)
+        if (p < counted_.size()) counted_[p] = 0;
+    matchJobs();
+}
+
+void CitizenSystem::remapBuildings(const std::vector<std::uint32_t>& newPosition) {
+    auto remap = [&newPosition](std::uint32_t b) { return b < newPosition.size() ? newPosition[b] : b; };
+    for (auto& h : home_) h = remap(h);
+    for (auto& w : work_)
+        if (w != NONE) w = remap(w);
+    for (auto& j : openJobs_) j.building = remap(j.building);
+    // pozitiile noi nu depasesc niciodata pe cele vechi, deci mutarea pe loc e sigura
+    std::size_t size = 0;
+    for (std::size_t i = 0; i < newPosition.size() && i < buildingStreet_.size(); ++i) {
+        if (newPosition[i] == NONE) continue;
+        buildingStreet_[newPosition[i]] = buildingStreet_[i];
+        if (i < counted_.size()) counted_[newPosition[i]] = counted_[i];
+        size = newPosition[i] + 1;
+    }
+    buildingStreet_.resize(size);
+    counted_.resize(size);
+}
+
+// acoperirea cu servicii (utilitati si parcuri) raportata la numarul de locuitori de pe strada
+void CitizenSystem::refreshServices(const std::vector<std::shared_ptr<Building>>& buildings, const std::vector<SlotRef>& placements, std::size_t streetCount) {
+    std::vector<double> supply(streetCount, 0.0), residents(streetCount, 0.0);
+    buildingStreet_.resize(buildings.size());
+    for (std::size_t i = 0; i < buildings.size(); ++i) {
+        const std::size_t st = placements[i].street;
+        buildingStreet_[i] = static_cast<std::uint32_t>(st);
+        if (st >= streetCount || !buildings[i]) continue;
+        const BuildingKind k = kindOf(*buildings[i]);
+        if (k == BuildingKind::Utility || k == BuildingKind::Park) supply[st] += buildings[i]->capacityEffect();
+        else if (k == BuildingKind::Residential) residents[st] += buildings[i]->capacityEffect();
+    }
+    streetService_.assign(streetCount, 0.0f);
+    for (std::size_t s = 0; s < streetCount; ++s)
+        streetService_[s] = residents[s] > 0.0 ? static_cast<float>(std::min(1.0, supply[s] / residents[s])) : 1.0f;
+}
+
+// un tick: satisfactia fiecarui cetatean se apropie de tinta data de servicii si loc de munca
+void CitizenSystem::update(unsigned threads) {
+    const std::size_t n = home_.size();
+    const std::size_t chunks = (n + CHUNK - 1) / CHUNK;
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::clamp<std::size_t>(chunks, 1, threads));
+
+    std::vector<double> satSum(threads, 0.0);
+    std::vector<std::uint64_t> empSum(threads, 0);
+    std::atomic<std::size_t> next{0};
+
+    auto worker = [&](unsigned t) {
+        const std::uint32_t* home = home_.data();
+        const std::uint32_t* work = work_.data();
+        float* sat = satisfaction_.data();
+        const std::uint32_t* street = buildingStreet_.data();
+        const float* service = streetService_.data();
+        const std::size_t streets = streetService_.size();
+        double localSat = 0.0;
+        std::uint64_t localEmp = 0;
+        for (std::size_t ch = next++; ch < chunks; ch = next++) {
+            const std::size_t end = std::min(n, (ch + 1) * CHUNK);
+            for (std::size_t i = ch * CHUNK; i < end; ++i) {
+                const std::uint32_t st = street[home[i]];
+                const float cover = st < streets ? service[st] : 0.0f;
+                const bool hasJob = work[i] != NONE;
+                const float target = SERVICE_WEIGHT * cover + (hasJob ? JOB_WEIGHT : 0.0f);
+                sat[i] += ADAPT_RATE * (target - sat[i]);
+                localSat += sat[i];
+                localEmp += hasJob;
+            }
+        }
+        satSum[t] = localSat;
+        empSum[t] = localEmp;
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker, t);
+    worker(0);
+    for (auto& th : pool) th.join();
+
+    double total = 0.0;
+    employed_ = 0;
+    for (unsigned t = 0; t < threads; ++t) {
+        total += satSum[t];
+        employed_ += empSum[t];
+    }
+    averageSatisfaction_ = n ? total / static_cast<double>(n) : 0.0;
+}
+
+std::size_t CitizenSystem::size() const noexcept {
+    return home_.size();
+}
+
+std::uint64_t CitizenSystem::employed() const noexcept {
+    return employed_;
+}
+
+double CitizenSystem::averageSatisfaction() const noexcept {
+    return averageSatisfaction_;
+}
+
+std::size_t CitizenSystem::memoryUsage() const noexcept {
+    return sizeof(*this)
+         + home_.capacity() * sizeof(std::uint32_t)
+         + work_.capacity() * sizeof(std::uint32_t)
+         + satisfaction_.capacity() * sizeof(float)
+         + buildingStreet_.capacity() * sizeof(std::uint32_t)
+         + counted_.capacity() * sizeof(int)
+         + streetService_.capacity() * sizeof(float)
+         + openJobs_.capacity() * sizeof(OpenJobs)
+         + jobless_.capacity() * sizeof(std::uint32_t);
+}
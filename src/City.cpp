@@ -1,15 +1,71 @@
 #include "../include/City.hpp"
 #include "../include/Exceptions.hpp"
+#include <algorithm>
+#include <bit>
 #include <iostream>
+#include <iterator>
+#include <sstream>
 #include <utility>
 #include "../include/EconomyVisitor.hpp"
+#include "../include/AutoSave.hpp"
+#include "../include/BuildingCatalog.hpp"
+#include "../include/MemoryUsage.hpp"
+#include "../include/NamePool.hpp"
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
 
-City::City(std::string n, int startingMoney) noexcept: name_(std::move(n)), money_(startingMoney) {}
+namespace {
 
-City::City(const City& other): name_(other.name_),money_(other.money_),resources_(other.resources_),streets_(other.streets_) {
+// fabricile nu sunt vizitate individual; productia lor e rulata de ProductionScheduler
+class UpgradeVisitor : public EconomyTickVisitor {
+public:
+    using EconomyTickVisitor::EconomyTickVisitor;
+    using EconomyTickVisitor::visit;
+    void visit(FactoryBuilding&) override {}
+};
+
+// muta elementele intr-un bloc nou daca vectorul tine mai mult decat `cap`
+template <typename T>
+void shrinkTo(std::vector<T>& v, std::size_t cap) {
+    if (v.capacity() <= cap) return;
+    std::vector<T> fitted;
+    fitted.reserve(std::max(cap, v.size()));
+    std::move(v.begin(), v.end(), std::back_inserter(fitted));
+    v.swap(fitted);
+}
+
+}
+
+City::City(std::string n, Money startingMoney): name_(std::move(n)),
+    catalogVersion_(BuildingCatalog::instance().version()) {
+    transfer(startingMoney, Account::Capital, "opening_balance");
+}
+
+City::City(const City& other): name_(other.name_),money_(other.money_),resources_(other.resources_),streets_(other.streets_),
+    placements_(other.placements_),ids_(other.ids_),slots_(other.slots_),freeIds_(other.freeIds_),caches_(other.caches_),holes_(other.holes_),
+    removedPositions_(other.removedPositions_),streetsWithSpace_(other.streetsWithSpace_),spaceHint_(other.spaceHint_),
+    streetTotals_(other.streetTotals_),totalSlots_(other.totalSlots_),
+    freeSlots_(other.freeSlots_),upkeep_(other.upkeep_),
+    tick_(other.tick_),metrics_(other.metrics_),metricsEnabled_(other.metricsEnabled_),wheel_(other.wheel_.now()),
+    citizens_(other.citizens_),citizensEnabled_(other.citizensEnabled_),workerThreads_(other.workerThreads_),servicesDirty_(other.servicesDirty_),
+    catalogVersion_(other.catalogVersion_),ledger_(other.ledger_),events_(other.events_),
+    eventsEnabled_(other.eventsEnabled_),onError_(other.onError_),journalStart_(other.tick_ + 1),
+    seenResources_(other.seenResources_),resourcesChanged_(other.resourcesChanged_),seenMoney_(other.seenMoney_),
+    moneyChanged_(other.moneyChanged_) {
     buildings_.reserve(other.buildings_.size());
-    for (const auto& b : other.buildings_)
-        buildings_.push_back(b->clone_shared());
+    for (std::size_t i = 0; i < other.buildings_.size(); ++i) {
+        const auto& b = other.buildings_[i];
+        buildings_.push_back(b ? b->clone_shared() : nullptr);
+        if (b && b->isUpgrading())
+            wheel_.schedule(b->upgradeDue(), BuildJob{buildings_.back(), false, {}, ids_[i]});
+    }
+    rebuildActive();
+    other.wheel_.forEach([this](std::uint64_t due, const BuildJob& job) {
+        if (job.construction)
+            wheel_.schedule(due, BuildJob{job.building->clone_shared(), true, job.slot, job.id});
+    });
+    bindStreets();   // clonele arata inca spre strazile orasului sursa
 }
 
 City& City::operator=(City other) noexcept {
@@ -24,16 +80,136 @@ void swap(City& a, City& b) noexcept {
     swap(a.resources_, b.resources_);
     swap(a.streets_, b.streets_);
     swap(a.buildings_, b.buildings_);
+    swap(a.placements_, b.placements_);
+    swap(a.ids_, b.ids_);
+    swap(a.slots_, b.slots_);
+    swap(a.freeIds_, b.freeIds_);
+    swap(a.caches_, b.caches_);
+    swap(a.holes_, b.holes_);
+    swap(a.removedPositions_, b.removedPositions_);
+    swap(a.streetsWithSpace_, b.streetsWithSpace_);
+    swap(a.spaceHint_, b.spaceHint_);
+    swap(a.streetTotals_, b.streetTotals_);
+    swap(a.totalSlots_, b.totalSlots_);
+    swap(a.freeSlots_, b.freeSlots_);
+    swap(a.upkeep_, b.upkeep_);
+    swap(a.production_, b.production_);
+    swap(a.productionDirty_, b.productionDirty_);
+    swap(a.tick_, b.tick_);
+    swap(a.metrics_, b.metrics_);
+    swap(a.metricsEnabled_, b.metricsEnabled_);
+    swap(a.wheel_, b.wheel_);
+    swap(a.active_, b.active_);
+    swap(a.citizens_, b.citizens_);
+    swap(a.citizensEnabled_, b.citizensEnabled_);
+    swap(a.workerThreads_, b.workerThreads_);
+    swap(a.servicesDirty_, b.servicesDirty_);
+    swap(a.catalogVersion_, b.catalogVersion_);
+    swap(a.ledger_, b.ledger_);
+    swap(a.events_, b.events_);
+    swap(a.eventsEnabled_, b.eventsEnabled_);
+    swap(a.eventsDirty_, b.eventsDirty_);
+    swap(a.pricesDirty_, b.pricesDirty_);
+    swap(a.onError_, b.onError_);
+    swap(a.journal_, b.journal_);
+    swap(a.journalStart_, b.journalStart_);
+    swap(a.seenResources_, b.seenResources_);
+    swap(a.resourcesChanged_, b.resourcesChanged_);
+    swap(a.seenMoney_, b.seenMoney_);
+    swap(a.moneyChanged_, b.moneyChanged_);
+}
+
+void City::markStreetSpace(std::size_t idx, bool hasSpace) {
+    if (idx / 64 >= streetsWithSpace_.size()) streetsWithSpace_.resize(idx / 64 + 1, 0);
+    const std::uint64_t bit = std::uint64_t{1} << (idx % 64);
+    if (hasSpace) {
+        streetsWithSpace_[idx / 64] |= bit;
+        spaceHint_ = std::min(spaceHint_, idx / 64);
+    } else streetsWithSpace_[idx / 64] &= ~bit;
+}
+
+// prima strada cu sloturi libere; bitii ramasi setati pentru strazi pline sunt stersi pe loc
+std::size_t City::findStreetWithSpace() {
+    for (std::size_t w = spaceHint_; w < streetsWithSpace_.size(); ++w) {
+        while (streetsWithSpace_[w] != 0) {
+            std::size_t idx = w * 64 + static_cast<std::size_t>(std::countr_zero(streetsWithSpace_[w]));
+            if (idx < streets_.size() && streets_[idx].freeSlots() > 0) {
+                spaceHint_ = w;
+                return idx;
+            }
+            markStreetSpace(idx, false);
+        }
+    }
+    spaceHint_ = streetsWithSpace_.size();
+    return streets_.size();
+}
+
+SlotRef City::placeOnStreet(std::size_t streetIdx) {
+    int slot = streets_[streetIdx].occupySlot();
+    if (slot < 0) throw LimitExceededException();
+    if (streets_[streetIdx].freeSlots() == 0) markStreetSpace(streetIdx, false);
+    --streetTotals_[streetIdx].freeSlots;
+    --freeSlots_;
+    return SlotRef{streetIdx, slot};
+}
+
+// aduna in totaluri diferenta dintre strada de acum si valorile ei numarate ultima data
+void City::refreshStreet(std::size_t idx) {
+    const Street& st = streets_[idx];
+    StreetTotals& t = streetTotals_[idx];
+    totalSlots_ += st.slotCount() - t.slots;
+    freeSlots_ += st.freeSlots() - t.freeSlots;
+    upkeep_ += st.upkeep() - t.upkeep;
+    t.slots = st.slotCount();
+    t.freeSlots = st.freeSlots();
+    t.upkeep = st.upkeep();
+}
+
+// cladirile si constructiile in curs tin pointeri la strazile lor, legati din slot
+void City::bindStreets() {
+    for (std::size_t i = 0; i < buildings_.size(); ++i)
+        if (buildings_[i]) buildings_[i]->bindStreet(&streets_[placements_[i].street]);
+    wheel_.forEach([this](std::uint64_t, const BuildJob& job) {
+        if (job.construction) job.building->bindStreet(&streets_[job.slot.street]);
+    });
 }
 
 void City::addStreet(const Street& s) {
+    const Street* before = streets_.data();
     streets_.push_back(s);
+    if (streets_.data() != before) bindStreets();   // vectorul s-a realocat
+    streetTotals_.emplace_back();
+    refreshStreet(streets_.size() - 1);
+    markStreetSpace(streets_.size() - 1, s.freeSlots() > 0);
+    journal({tick_, ChangeRecord::Kind::Street, nullptr, {}, SlotRef{streets_.size() - 1, -1}, UINT64_MAX});
 }
 
-Street* City::getStreet(std::size_t idx) {
-    if (idx >= streets_.size())
-        return nullptr;
-    return &streets_[idx];
+std::size_t City::streetCount() const noexcept {
+    return streets_.size();
+}
+
+bool City::widenStreet(std::size_t idx) {
+    if (idx >= streets_.size()) throw InvalidIndexException();
+    const std::uint64_t revision = streets_[idx].revision();
+    if (!streets_[idx].widen()) return false;
+    journal({tick_, ChangeRecord::Kind::Street, nullptr, {}, SlotRef{idx, -1}, revision});
+    refreshStreet(idx);
+    return true;
+}
+
+// sloturile noi intra in totaluri si strada e marcata din nou cu loc liber
+bool City::extendStreet(std::size_t idx, int segment) {
+    if (idx >= streets_.size()) throw InvalidIndexException();
+    const std::uint64_t revision = streets_[idx].revision();
+    if (!streets_[idx].addSegment(segment)) return false;
+    journal({tick_, ChangeRecord::Kind::Street, nullptr, {}, SlotRef{idx, -1}, revision});
+    refreshStreet(idx);
+    markStreetSpace(idx, true);
+    return true;
+}
+
+Money City::upkeep() const noexcept {
+    return upkeep_;
 }
 
 const Street* City::getStreet(std::size_t idx) const {
@@ -48,82 +224,724 @@ void City::addResource(const std::string& type, int amount) {
 }
 
 
-void City::setMoney(int m) noexcept {
-    money_ = m;
+// corectie din afara simularii: diferenta e inregistrata pe contul de capital
+void City::setMoney(Money m) {
+    transfer(m - money_, Account::Capital, "adjustment");
 }
 
-int City::money() const noexcept {
+Money City::money() const noexcept {
     return money_;
 }
+
+void City::transfer(Money delta, Account counterpart, std::string_view memo) {
+    const NameRef tag = memo.empty() ? NameRef{} : NamePool::instance().intern(memo);
+    if (delta > 0) ledger_.post(Account::Treasury, counterpart, delta, tag);
+    else if (delta < 0) ledger_.post(counterpart, Account::Treasury, -delta, tag);
+    money_ += delta;
+}
+
+const Ledger& City::ledger() const noexcept {
+    return ledger_;
+}
+
+void City::openLedgerLog(const std::string& path, bool truncate) {
+    ledger_.openLog(path, truncate);
+}
+
+void City::commitLedger() {
+    ledger_.commit();
+}
+
+// diferenta de bani lasata de upgrade-ul unei cladiri
+void City::recordUpgrade(const Building& b, Money before) {
+    if (money_ > before) ledger_.post(Account::Treasury, Account::UpgradeIncome, money_ - before, b.nameRef());
+    else if (money_ < before) ledger_.post(Account::UpgradeExpense, Account::Treasury, before - money_, b.nameRef());
+}
+
+void City::payPark(const Building& b) {
+    const auto* p = dynamic_cast<const Park*>(&b);
+    if (!p) return;
+    if (money_ < p->cost()) throw CityException("Not enough money for park");
+    money_ -= p->cost();
+    ledger_.post(Account::ParkPurchase, Account::Treasury, p->cost(), b.nameRef());
+}
 // creaza si adauga cladire prin creator
-void City::addBuilding(const std::string& typeId, const std::string& name, const std::vector<std::string>& params, std::size_t streetIdx) {
-    Street* st = getStreet(streetIdx);
+BuildingId City::addBuilding(const std::string& typeId, const std::string& name, const std::vector<std::string>& params, std::size_t streetIdx) {
+    const Street* st = getStreet(streetIdx);
+    if (!st) throw InvalidIndexException();
+    if (st->freeSlots() == 0) throw LimitExceededException();
+    return addCreatedBuilding(BuildingCreator::instance().create(typeId, name, params, st), streetIdx);
+}
+
+// cladire deja construita (de ex. de incarcatorul paralel): aceleasi verificari si costuri ca addBuilding
+BuildingId City::addCreatedBuilding(std::shared_ptr<Building> b, std::size_t streetIdx) {
+    const Street* st = getStreet(streetIdx);
+    if (!st) throw InvalidIndexException();
+    if (st->freeSlots() == 0) throw LimitExceededException();
+    payPark(*b);
+    return commitBuilding(std::move(b), placeOnStreet(streetIdx));
+}
+
+// constructie care dureaza `ticks`; slotul e rezervat de acum, cladirea apare in oras la final
+BuildingId City::scheduleConstruction(const std::string& typeId, const std::string& name, const std::vector<std::string>& params, std::size_t streetIdx, int ticks) {
+    if (ticks <= 0) return addBuilding(typeId, name, params, streetIdx);
+    const Street* st = getStreet(streetIdx);
+    if (!st) throw InvalidIndexException();
+    if (st->freeSlots() == 0) throw LimitExceededException();
     auto b = BuildingCreator::instance().create(typeId, name, params, st);
-    if (auto p = std::dynamic_pointer_cast<Park>(b)) {
-        if (money_ < p->cost()) throw CityException("Not enough money for park");
-        money_ -= p->cost();
+    payPark(*b);
+    const SlotRef ref = placeOnStreet(streetIdx);
+    const BuildingId id = allocateId();
+    wheel_.schedule(tick_ + static_cast<std::uint64_t>(ticks), BuildJob{std::move(b), true, ref, id});
+    return id;
+}
+
+std::size_t City::pendingJobs() const noexcept {
+    return wheel_.size();
+}
+
+// o intrare libera din tabela, sau una noua; generatia ei e deja cea urmatoare eliberarii
+BuildingId City::allocateId() {
+    if (freeIds_.empty()) {
+        slots_.push_back({});
+        return {static_cast<std::uint32_t>(slots_.size() - 1), 0};
     }
+    const std::uint32_t index = freeIds_.back();
+    freeIds_.pop_back();
+    return {index, slots_[index].generation};
+}
+
+std::size_t City::positionOf(BuildingId id) const noexcept {
+    if (id.index >= slots_.size() || slots_[id.index].generation != id.generation) return buildings_.size();
+    const std::uint32_t pos = slots_[id.index].position;
+    return pos == UNPLACED ? buildings_.size() : pos;
+}
+
+BuildingId City::commitBuilding(std::shared_ptr<Building> b, SlotRef ref, BuildingId id) {
+    if (!id.valid()) id = allocateId();
+    slots_[id.index].position = static_cast<std::uint32_t>(buildings_.size());
+    placements_.push_back(ref);
+    ids_.push_back(id);
+    trackUpgrade(b, id);   // cladire cu upgrade inceput in afara orasului (ex. in cartier)
+    if (!b->isMaxed() && !b->isUpgrading()) active_.push_back(id);
+    journal({tick_, ChangeRecord::Kind::BuildingAdded, b.get(), {}, ref, 0});
+    b->bindStreet(&streets_[ref.street]);
+    markKindDirty(*b);
     buildings_.push_back(std::move(b));
+    if (citizensEnabled_) citizens_.onBuildingAdded(buildings_.size() - 1, *buildings_.back(), ref);
+    return id;
+}
+
+// tabelele productiei si ale evenimentelor depind doar de unele tipuri de cladiri
+void City::markKindDirty(Building& b) {
+    const BuildingKind k = kindOf(b);
+    if (k == BuildingKind::Factory) productionDirty_ = true;
+    if (k == BuildingKind::Utility || k == BuildingKind::Commercial) eventsDirty_ = true;
+    servicesDirty_ = true;
+}
+
+// un upgrade cu durata tocmai a inceput: il programam pe roata
+void City::trackUpgrade(const std::shared_ptr<Building>& b, BuildingId id) {
+    if (!b->isUpgrading() || b->upgradeDue() != 0) return;
+    const std::uint64_t due = tick_ + static_cast<std::uint64_t>(b->upgradeTicks());
+    b->setUpgradeDue(due);
+    wheel_.schedule(due, BuildJob{b, false, {}, id});
+}
+
+void City::rebuildActive() {
+    active_.clear();
+    for (std::size_t i = 0; i < buildings_.size(); ++i) {
+        const auto& b = buildings_[i];
+        if (b && !b->isMaxed() && !b->isUpgrading()) active_.push_back(ids_[i]);
+    }
+}
+
+// doar cladirile care pot creste; cele la nivel maxim, in lucru sau demolate ies din lista
+void City::upgradeActiveBuildings() {
+    UpgradeVisitor v(resources_, money_, producedStats_);
+    std::size_t keep = 0;
+    for (std::size_t i = 0; i < active_.size(); ++i) {
+        const BuildingId id = active_[i];
+        const std::size_t pos = positionOf(id);
+        if (pos == buildings_.size()) continue;
+        const auto& b = buildings_[pos];
+        if (!b->isMaxed() && !b->isUpgrading()) {
+            const int before = b->level();
+            const std::uint64_t revision = b->revision();
+            const Money moneyBefore = money_;
+            try {
+                b->accept(v);
+            } catch (const CityException& e) {
+                reportError(*b, e);
+            }
+            recordUpgrade(*b, moneyBefore);
+            trackUpgrade(b, id);
+            if (b->revision() != revision) noteChange(*b);
+            if (b->level() != before) servicesDirty_ = true;
+        }
+        if (!b->isMaxed() && !b->isUpgrading()) active_[keep++] = id;
+    }
+    active_.resize(keep);
 }
 
 
 void City::upgradeAllBuildings() {
-    EconomyTickVisitor v(resources_, money_, producedStats_);
-    for (auto& b : buildings_) {
+    UpgradeVisitor v(resources_, money_, producedStats_);
+    for (std::size_t i = 0; i < buildings_.size(); ++i) {
+        const auto& b = buildings_[i];
+        if (!b) continue;
+        const std::uint64_t revision = b->revision();
+        const Money moneyBefore = money_;
         try {
             b->accept(v);
         } catch (const CityException& e) {
-            std::cout << "Error on building " << b->name() << ": " << e.what() << "\n";
+            reportError(*b, e);
         }
+        recordUpgrade(*b, moneyBefore);
+        trackUpgrade(b, ids_[i]);
+        if (b->revision() != revision) noteChange(*b);
     }
+    rebuildActive();
+    servicesDirty_ = true;
+    runProduction();
+}
+
+// ruleaza lanturile de productie, nivel cu nivel
+void City::runProduction() {
+    if (productionDirty_) {
+        production_.rebuild(buildings_);
+        productionDirty_ = false;
+        pricesDirty_ = eventsEnabled_;
+        for (const auto& f : production_.blocked()) reportError(*f, CityException("Production chain contains a cycle"));
+    }
+    if (pricesDirty_) {
+        production_.applyPrices([this](const std::string& r) { return events_.price(r); });
+        pricesDirty_ = false;
+    }
+    production_.run(resources_, money_, ledger_, producedStats_, [this](const Building& b, const CityException& e) {
+        reportError(b, e);
+    });
+}
+// un pas de simulare: lucrarile scadente, upgrade-uri, productie, apoi esantionarea metricilor
+void City::tick() {
+    if (BuildingCatalog::instance().version() != catalogVersion_) applyCatalog();
+    if (holes_ * 4 > buildings_.size()) compact();
+    else flushRemovals();
+    ++tick_;
+    ledger_.setTick(tick_);
+    wheel_.advance(tick_, [this](std::uint64_t due, BuildJob& job) {
+        if (job.construction) {
+            commitBuilding(std::move(job.building), job.slot, job.id);
+            return;
+        }
+        // upgrade anulat (cladire demolata) sau reprogramat
+        if (job.building->upgradeDue() != due) return;
+        job.building->finishUpgrade();
+        noteChange(*job.building);
+        servicesDirty_ = true;
+        if (!job.building->isMaxed()) active_.push_back(job.id);
+    });
+    if (eventsEnabled_) runEvents();
+    upgradeActiveBuildings();
+    runProduction();
+    if (citizensEnabled_) {
+        if (servicesDirty_) {
+            citizens_.syncCapacity(buildings_);
+            citizens_.refreshServices(buildings_, placements_, streets_.size());
+        }
+        servicesDirty_ = false;
+        citizens_.update(workerThreads_);
+    }
+    if (metricsEnabled_) {
+        if (metrics_.use_count() > 1) metrics_ = std::make_shared<CityMetrics>(*metrics_);
+        metrics_->sample(tick_, money_, totalCapacity(), resources_.raw());
+    }
+    noteEconomy();
+    ledger_.commit();
+}
+
+// leaga toate cladirile (si cele in constructie) de tabelele curente ale catalogului,
+// intr-o singura trecere intre doua tick-uri; utilitatile, parcurile si fabricile raman
+// cu valorile de la creare (bindCatalog nu face nimic pentru ele)
+void City::applyCatalog() {
+    catalogVersion_ = BuildingCatalog::instance().version();
+    const auto tables = BuildingCatalog::instance().current();
+    for (const auto& b : buildings_)
+        if (b) b->bindCatalog(*tables);
+    wheel_.forEach([&tables](std::uint64_t, const BuildJob& job) {
+        if (job.construction) job.building->bindCatalog(*tables);
+    });
+    servicesDirty_ = true;
+}
+
+void City::enableEvents(const EventConfig& config, std::uint64_t seed) {
+    events_ = CityEvents(config, seed);
+    eventsEnabled_ = true;
+    eventsDirty_ = true;
+}
+
+void City::seedEvents(std::uint64_t seed) noexcept {
+    events_.setSeed(seed);
+}
+
+const CityEvents* City::events() const noexcept {
+    return eventsEnabled_ ? &events_ : nullptr;
+}
+
+void City::runEvents() {
+    if (eventsDirty_) {
+        std::vector<std::uint64_t> keys(ids_.size());
+        std::ranges::transform(ids_, keys.begin(), &BuildingId::key);
+        events_.rebuild(buildings_, keys);
+        eventsDirty_ = false;
+    }
+    const EventOutcome out = events_.evaluate(tick_, resources_.raw());
+    for (const Building* b : events_.changed()) noteChange(*b);
+    if (out.services) servicesDirty_ = true;
+    if (out.prices) pricesDirty_ = true;
+}
+
+std::uint64_t City::currentTick() const noexcept {
+    return tick_;
 }
+
+const CityMetrics& City::metrics() const noexcept {
+    return *metrics_;
+}
+
+void City::setMetricsEnabled(bool enabled) noexcept {
+    metricsEnabled_ = enabled;
+}
+
+void City::setWorkerThreads(unsigned threads) noexcept {
+    workerThreads_ = threads;
+}
+
+void City::setErrorHandler(ErrorHandler handler) {
+    onError_ = std::move(handler);
+}
+
+void City::reportError(const Building& b, const CityException& e, const char* prefix) const {
+    if (onError_) onError_(b, e);
+    else std::cout << prefix << b.name() << ": " << e.what() << "\n";
+}
+
 // upgrade doar pentru cladiri rezidentiale (dynamic_cast)
 void City::upgradeResidentialOnly() {
-    for (auto& b : buildings_) {
+    for (std::size_t i = 0; i < buildings_.size(); ++i) {
+        const auto& b = buildings_[i];
         if (auto r = std::dynamic_pointer_cast<ResidentialBuilding>(b)) {
+            const std::uint64_t revision = r->revision();
+            const Money moneyBefore = money_;
             try {
                 r->upgrade(resources_, money_);
             } catch (const InsufficientResourceException& e) {
-                std::cout << "Residential upgrade failed for " << r->name()<< ": " << e.what() << "\n";
+                reportError(*r, e, "Residential upgrade failed for ");
             }
+            recordUpgrade(*r, moneyBefore);
+            trackUpgrade(b, ids_[i]);
+            if (r->revision() != revision) noteChange(*r);
         }
     }
+    rebuildActive();
+    servicesDirty_ = true;
 }
 
 int City::maxBuildings() const noexcept {
-    int totalSegments = 0;
-    for (const auto& s : streets_) totalSegments += s.length();
-    return totalSegments * 2;
+    return totalSlots_;
 }
-// adauga cladire direct, fara creator
-void City::addBuildingDirect(std::shared_ptr<Building> b) {
-    if (static_cast<int>(buildings_.size()) >= maxBuildings())
+// adauga cladire direct, fara creator, in primul slot liber din oras
+BuildingId City::addBuildingDirect(std::shared_ptr<Building> b) {
+    std::size_t streetIdx = findStreetWithSpace();
+    if (streetIdx == streets_.size())
         throw LimitExceededException();
-    buildings_.push_back(std::move(b));
+    return commitBuilding(std::move(b), placeOnStreet(streetIdx));
+}
+
+// demolare – elibereaza slotul de pe strada; intrarea din tabela primeste o generatie noua,
+// ca vechiul identificator sa nu mai gaseasca nimic. Lista activa si cetatenii afla la tick-ul urmator
+void City::demolishBuilding(BuildingId id) {
+    if (id.index < slots_.size() && slots_[id.index].generation == id.generation && slots_[id.index].position == UNPLACED) {
+        cancelConstruction(id);
+        return;
+    }
+    const std::size_t pos = positionOf(id);
+    if (pos == buildings_.size()) throw InvalidIndexException();
+    auto& b = buildings_[pos];
+    const SlotRef ref = placements_[pos];
+    journal({tick_, ChangeRecord::Kind::BuildingRemoved, b.get(), b->nameRef(), ref, 0});
+    releaseSlot(ref);
+    b->cancelUpgrade();
+    markKindDirty(*b);
+    b.reset();
+    ids_[pos] = {};
+    releaseId(id);
+    ++holes_;
+    if (citizensEnabled_) removedPositions_.push_back(static_cast<std::uint32_t>(pos));
+}
+
+// cladirea n-a aparut inca in oras, deci nu lasa gol si nu e in jurnal
+void City::cancelConstruction(BuildingId id) {
+    SlotRef ref;
+    const std::size_t removed = wheel_.removeIf([&](const BuildJob& job) {
+        if (!job.construction || job.id != id) return false;
+        ref = job.slot;
+        return true;
+    });
+    // intrare libera cu generatia curenta: nu apartine niciunei cladiri
+    if (removed == 0) throw InvalidIndexException();
+    releaseSlot(ref);
+    releaseId(id);
+}
+
+void City::releaseSlot(const SlotRef& ref) {
+    streets_[ref.street].releaseSlot(ref.slot);
+    markStreetSpace(ref.street, true);
+    ++streetTotals_[ref.street].freeSlots;
+    ++freeSlots_;
+}
+
+void City::releaseId(BuildingId id) {
+    IdSlot& slot = slots_[id.index];
+    slot.position = UNPLACED;
+    if (id.index < caches_.size()) caches_[id.index] = {};
+    // o intrare cu generatia epuizata nu mai e refolosita
+    if (++slot.generation != UINT32_MAX) freeIds_.push_back(id.index);
+}
+
+// cetatenii afla de demolari o data pe tick, intr-o singura trecere
+void City::flushRemovals() {
+    if (removedPositions_.empty()) return;
+    citizens_.removeBuildings(removedPositions_);
+    removedPositions_.clear();
+}
+
+// mutarea e stabila, deci ordinea de parcurgere ramane ordinea adaugarii
+void City::compact() {
+    if (holes_ == 0) return;
+    flushRemovals();
+    std::vector<std::uint32_t> moved(buildings_.size(), CitizenSystem::NONE);
+    std::size_t keep = 0;
+    for (std::size_t i = 0; i < buildings_.size(); ++i) {
+        if (!buildings_[i]) continue;
+        if (keep != i) {
+            buildings_[keep] = std::move(buildings_[i]);
+            placements_[keep] = placements_[i];
+            ids_[keep] = ids_[i];
+        }
+        slots_[ids_[keep].index].position = static_cast<std::uint32_t>(keep);
+        moved[i] = static_cast<std::uint32_t>(keep);
+        ++keep;
+    }
+    buildings_.resize(keep);
+    placements_.resize(keep);
+    ids_.resize(keep);
+    holes_ = 0;
+    // la inlocuiri lista creste cu cel mult o treime pana la urmatoarea compactare (golurile trec de un sfert)
+    const std::size_t cap = keep + keep / 3 + 1;
+    shrinkTo(buildings_, cap);
+    shrinkTo(placements_, cap);
+    shrinkTo(ids_, cap);
+    shrinkTo(removedPositions_, cap);
+    if (citizensEnabled_) citizens_.remapBuildings(moved);
 }
 
 int City::remainingSlots() const noexcept {
-    return maxBuildings() - static_cast<int>(buildings_.size());
+    return freeSlots_;
+}
+
+std::size_t City::buildingTotal() const noexcept {
+    return buildings_.size() - holes_;
+}
+
+std::vector<BuildingId> City::buildingIds() const {
+    std::vector<BuildingId> ids;
+    ids.reserve(buildingTotal());
+    for (const BuildingId& id : ids_)
+        if (id.valid()) ids.push_back(id);
+    return ids;
+}
+
+Building* City::building(BuildingId id) noexcept {
+    const std::size_t pos = positionOf(id);
+    return pos == buildings_.size() ? nullptr : buildings_[pos].get();
+}
+
+const Building* City::building(BuildingId id) const noexcept {
+    const std::size_t pos = positionOf(id);
+    return pos == buildings_.size() ? nullptr : buildings_[pos].get();
+}
+
+const SlotRef& City::placement(BuildingId id) const {
+    const std::size_t pos = positionOf(id);
+    if (pos == buildings_.size()) throw InvalidIndexException();
+    return placements_[pos];
+}
+
+std::ostream& operator<<(std::ostream& os, const BuildingId& id) {
+    os << id.index;
+    if (id.generation != 0) os << 'g' << id.generation;
+    return os;
 }
 
 void City::printSummary() const {
-    std::cout << "City: " << name_ << " (Money=" << money() << ", BuildingsTotal=" << Building::buildingCount() << ", MaxBuildings=" << maxBuildings() << ", RemainingSlots=" << remainingSlots() << ", TotalCapacity=" << totalCapacity() << ")\nResources:\n";
+    std::cout << "City: " << name_ << " (Money=" << money() << ", BuildingsTotal=" << buildingTotal() << ", MaxBuildings=" << maxBuildings() << ", RemainingSlots=" << remainingSlots() << ", Upkeep=" << upkeep() << ", TotalCapacity=" << totalCapacity() << ")\nResources:\n";
     std::cout << "Produced stats:\n";
     for (const auto& kv : producedStats_.raw())
         std::cout << "  " << kv.first << ": " << kv.second << "\n";
     std::cout << "Streets:\n";
     for (std::size_t i = 0; i < streets_.size(); ++i) {
         const Street& st = streets_[i];
-        std::cout << " [" << i << "] " << st << " (type=" << st.roadType()<< ", level="  << st.level() << ", length=" << st.length() << ")\n";
+        std::cout << " [" << i << "] " << st.rendered() << " (type=" << st.roadType()<< ", level="  << st.level() << ", length=" << st.length() << ")\n";
     }
     std::cout << "Buildings:\n";
     for (std::size_t i = 0; i < buildings_.size(); ++i)
-        std::cout << " [" << i << "] " << *buildings_[i] << "\n";
+    {
+        if (!buildings_[i]) continue;
+        std::cout << " [" << ids_[i] << "] " << renderedAt(i) << " @street " << placements_[i].street << "/slot " << placements_[i].slot;
+        if (buildings_[i]->isUpgrading())
+            std::cout << " (upgrading until tick " << buildings_[i]->upgradeDue() << ")";
+        std::cout << "\n";
+    }
+}
+
+void City::journal(const ChangeRecord& r) {
+    journal_.push_back(r);
+    if (journal_.size() <= JOURNAL_LIMIT) return;
+    // intrarile ramase din tick-ul scos pot fi incomplete
+    journalStart_ = std::max(journalStart_, journal_.front().tick + 1);
+    journal_.pop_front();
+}
+
+void City::noteChange(const Building& b) {
+    journal({tick_, ChangeRecord::Kind::Building, &b, {}, SlotRef{}, 0});
+}
+
+// stocul si banii se schimba la aproape fiecare tick, deci tinem doar tick-ul ultimei schimbari
+void City::noteEconomy() {
+    if (resources_.version() != seenResources_) {
+        seenResources_ = resources_.version();
+        resourcesChanged_ = tick_;
+    }
+    if (money_ != seenMoney_) {
+        seenMoney_ = money_;
+        moneyChanged_ = tick_;
+    }
+}
+
+// parcurge doar jurnalul de la `sinceTick`; o cladire apare o singura data, cu starea de acum.
+// Jurnalul e citit de la coada spre inceput: prima intrare gasita pentru o adresa e cea mai noua,
+// iar o demolare inchide adresa pentru intrarile mai vechi (adresa poate fi refolosita).
+void City::printChanges(std::uint64_t sinceTick) const {
+    std::cout << "Changes since tick " << sinceTick << " (now " << tick_ << "):\n";
+    if (sinceTick < journalStart_) {
+        std::cout << "Journal starts at tick " << journalStart_ << ", full summary follows\n";
+        printSummary();
+        return;
+    }
+    if (moneyChanged_ >= sinceTick || money_ != seenMoney_) std::cout << "Money=" << money_ << "\n";
+    if (resourcesChanged_ >= sinceTick || resources_.version() != seenResources_) {
+        std::cout << "Resources:";
+        for (const auto& kv : resources_.raw()) std::cout << " " << kv.first << "=" << kv.second;
+        std::cout << "\n";
+    }
+
+    const auto first = std::ranges::lower_bound(journal_, sinceTick, {}, &ChangeRecord::tick);
+    std::map<std::size_t, std::uint64_t> streets;   // strada -> revizia de la prima intrare
+    struct Seen {
+        bool closed;
+        const ChangeRecord* added;
+    };
+    std::unordered_map<const Building*, Seen> seen;
+    std::vector<const ChangeRecord*> live, removed;
+    for (auto it = journal_.end(); it != first;) {
+        const ChangeRecord& r = *--it;
+        if (r.kind == ChangeRecord::Kind::Street) {
+            streets[r.slot.street] = r.revision;   // ultima scrisa e cea mai veche
+            continue;
+        }
+        auto [pos, inserted] = seen.try_emplace(r.building, Seen{false, nullptr});
+        if (r.kind == ChangeRecord::Kind::BuildingRemoved) {
+            removed.push_back(&r);
+            pos->second.closed = true;
+            continue;
+        }
+        if (pos->second.closed) continue;
+        if (inserted) live.push_back(&r);
+        if (r.kind == ChangeRecord::Kind::BuildingAdded) pos->second.added = &r;
+    }
+
+    bool header = false;
+    for (const auto& [idx, revision] : streets) {
+        const Street& st = streets_[idx];
+        if (st.revision() == revision) continue;
+        if (!header) std::cout << "Streets:\n";
+        header = true;
+        std::cout << " [" << idx << "] " << st.rendered() << " (type=" << st.roadType() << ", level=" << st.level()
+                  << ", length=" << st.length() << ")\n";
+    }
+    if (!live.empty() || !removed.empty()) std::cout << "Buildings:\n";
+    for (auto it = live.rbegin(); it != live.rend(); ++it) {
+        const Building& b = *(*it)->building;
+        const ChangeRecord* added = seen.at(&b).added;
+        std::cout << (added ? " + " : " ~ ") << b;
+        if (added) std::cout << " @street " << added->slot.street << "/slot " << added->slot.slot;
+        if (b.isUpgrading()) std::cout << " (upgrading until tick " << b.upgradeDue() << ")";
+        std::cout << "\n";
+    }
+    for (auto it = removed.rbegin(); it != removed.rend(); ++it)
+        std::cout << " - " << *(*it)->name << " @street " << (*it)->slot.street << "/slot " << (*it)->slot.slot << "\n";
 }
 
 int City::totalCapacity() const noexcept {
     int tot = 0;
     for (const auto& b : buildings_)
-        tot += b->capacityEffect();
+        if (b) tot += b->capacityEffect();
     return tot;
 }
+
+// instantaneu pe coloane al cladirilor, pentru interogari
+BuildingColumns City::columns() const {
+    BuildingColumns c;
+    c.reserve(buildingTotal());
+    for (std::size_t i = 0; i < buildings_.size(); ++i) {
+        if (!buildings_[i]) continue;
+        Building& b = *buildings_[i];
+        c.append(kindOf(b), static_cast<std::uint32_t>(placements_[i].street), b.level(), b.maxLevel(), b.capacityEffect());
+    }
+    return c;
+}
+
+// creeaza cetatenii pentru cladirile existente; de aici incolo sunt actualizati la fiecare tick
+void City::populateCitizens() {
+    removedPositions_.clear();
+    citizens_.rebuild(buildings_, placements_, streets_.size());
+    citizensEnabled_ = true;
+    servicesDirty_ = false;
+}
+
+const CitizenSystem& City::citizens() const noexcept {
+    return citizens_;
+}
+
+City::BuildingCache& City::cacheAt(std::size_t pos) const {
+    const std::uint32_t index = ids_[pos].index;
+    if (index >= caches_.size()) caches_.resize(slots_.size());
+    return caches_[index];
+}
+
+// textul depinde si de strada (nivel, segmente), deci cheia include revizia ei
+const std::string& City::renderedAt(std::size_t pos) const {
+    const Building& b = *buildings_[pos];
+    BuildingCache& c = cacheAt(pos);
+    const std::uint64_t streetRevision = streets_[placements_[pos].street].revision();
+    if (c.renderedRevision != b.revision() || c.renderedStreet != streetRevision) {
+        std::ostringstream os;
+        b.print(os);
+        c.rendered = std::move(os).str();
+        c.renderedRevision = b.revision();
+        c.renderedStreet = streetRevision;
+    }
+    return c.rendered;
+}
+
+// inregistrarea e partajata cu snapshot-urile inca nescrise, deci una noua e alocata doar dupa o schimbare
+std::shared_ptr<const BuildingRecord> City::recordAt(std::size_t pos) const {
+    Building& b = *buildings_[pos];
+    BuildingCache& c = cacheAt(pos);
+    if (!c.record || c.recordRevision != b.revision()) {
+        c.record = std::make_shared<const BuildingRecord>(BuildingRecord{kindName(kindOf(b)), b.name(), b.saveParams()});
+        c.recordRevision = b.revision();
+    }
+    return c.record;
+}
+
+// captura ieftina pentru salvare: copii de valori si inregistrarile din cache ale cladirilor;
+// doar cladirile schimbate de la salvarea trecuta isi refac inregistrarea
+CitySnapshot City::snapshot() const {
+    CitySnapshot snap;
+    snap.tick = tick_;
+    snap.name = name_;
+    snap.money = money_;
+    snap.resources = resources_.raw();
+    snap.produced = producedStats_.raw();
+    snap.streets = streets_;
+    snap.buildings.reserve(buildingTotal());
+    snap.buildingStreets.reserve(buildingTotal());
+    for (std::size_t i = 0; i < buildings_.size(); ++i) {
+        if (!buildings_[i]) continue;
+        snap.buildings.push_back(recordAt(i));
+        snap.buildingStreets.push_back(placements_[i].street);
+    }
+    return snap;
+}
+
+// strazile sunt refacute din nivel si segmente, ca sloturile sa fie ocupate doar de cladirile adaugate aici
+City City::restore(const CitySnapshot& snap) {
+    City city(snap.name, snap.money);
+    for (const Street& st : snap.streets) {
+        Street fresh(st.level());
+        for (int i = 0; i < st.length(); ++i) fresh.addSegment(st.segment(static_cast<std::size_t>(i)));
+        city.addStreet(fresh);
+    }
+    for (const auto& [name, qty] : snap.resources) city.addResource(name, qty);
+    for (const auto& [name, qty] : snap.produced) city.producedStats_.add(name, qty);
+    for (std::size_t i = 0; i < snap.buildings.size(); ++i) {
+        const BuildingRecord& r = *snap.buildings[i];
+        const std::size_t streetIdx = snap.buildingStreets[i];
+        const Street* st = city.getStreet(streetIdx);
+        if (!st) throw InvalidIndexException();
+        if (st->freeSlots() == 0) throw LimitExceededException();
+        city.commitBuilding(BuildingCreator::instance().create(r.kind, r.name, r.params, st), city.placeOnStreet(streetIdx));
+    }
+    return city;
+}
+
+std::size_t CityMemory::total() const noexcept {
+    std::size_t sum = buildingIndex + streets + resources + stats + names + citizens + scheduling + ledger + other;
+    for (std::size_t b : buildings) sum += b;
+    return sum;
+}
+
+// fiecare cladire e alocata cu make_shared: obiectul plus blocul de control (contoare + vptr)
+CityMemory City::memoryUsage() const {
+    constexpr std::size_t CONTROL_BLOCK = 2 * sizeof(int) + sizeof(void*);
+    CityMemory m;
+    std::unordered_set<const std::string*> names;
+    for (const auto& b : buildings_) {
+        if (!b) continue;
+        m.buildings[static_cast<std::size_t>(kindOf(*b))] += b->memoryUsage() + CONTROL_BLOCK;
+        names.insert(&b->name());
+    }
+    m.buildingIndex = buildings_.capacity() * sizeof(std::shared_ptr<Building>)
+                    + placements_.capacity() * sizeof(SlotRef)
+                    + ids_.capacity() * sizeof(BuildingId)
+                    + slots_.capacity() * sizeof(IdSlot)
+                    + (freeIds_.capacity() + removedPositions_.capacity()) * sizeof(std::uint32_t)
+                    + active_.capacity() * sizeof(BuildingId)
+                    + streetsWithSpace_.capacity() * sizeof(std::uint64_t);
+
+    m.streets = (streets_.capacity() - streets_.size()) * sizeof(Street) + streetTotals_.capacity() * sizeof(StreetTotals);
+    for (const auto& st : streets_) m.streets += st.memoryUsage();
+
+    m.resources = mapMemory(resources_.raw());
+    // istoricul impartit cu alte copii e numarat proportional
+    m.stats = mapMemory(producedStats_.raw()) + metrics_->memoryUsage() / static_cast<std::size_t>(metrics_.use_count());
+
+    m.scheduling = wheel_.memoryUsage() + production_.memoryUsage();
+    wheel_.forEach([&](std::uint64_t, const BuildJob& job) {
+        if (!job.construction) return;
+        m.scheduling += job.building->memoryUsage() + CONTROL_BLOCK;
+        names.insert(&job.building->name());
+    });
+
+    for (const std::string* n : names) m.names += sizeof(std::string) + stringHeap(*n);
+    m.citizens = citizens_.memoryUsage();
+    m.ledger = ledger_.memoryUsage();
+    m.scheduling += events_.memoryUsage();
+    m.other = sizeof(*this) - sizeof(citizens_) - sizeof(wheel_) - sizeof(production_) - sizeof(ledger_)
+            - sizeof(events_) + stringHeap(name_) + journal_.size() * sizeof(ChangeRecord)
+            + caches_.capacity() * sizeof(BuildingCache);
+    for (const auto& c : caches_) m.other += stringHeap(c.rendered);
+    return m;
+}
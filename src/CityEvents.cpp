@@ -0,0 +1,152 @@
+#include "../include/CityEvents.hpp"
+#include "../include/Exceptions.hpp"
+#include "../include/MemoryUsage.hpp"
+
+CityEvents::CityEvents(EventConfig config, std::uint64_t seed) : rng_{seed}, config_(config) {
+    if (config_.outageTicks <= 0 || config_.demandTicks <= 0 || config_.priceTicks <= 0)
+        throw CityException("Event durations must be positive");
+    if (config_.demandMin > config_.demandMax || config_.priceMin > config_.priceMax || config_.demandMin < 0.0 || config_.priceMin < 0.0)
+        throw CityException("Invalid event ranges");
+}
+
+// copia pastreaza starea evenimentelor, dar tabelele arata spre cladirile celuilalt oras
+CityEvents::CityEvents(const CityEvents& other)
+    : rng_(other.rng_), config_(other.config_), stats_(other.stats_), prices_(other.prices_) {}
+
+CityEvents& CityEvents::operator=(const CityEvents& other) {
+    if (this != &other) {
+        rng_ = other.rng_;
+        config_ = other.config_;
+        stats_ = other.stats_;
+        prices_ = other.prices_;
+        utilities_.clear();
+        utilityKeys_.clear();
+        shops_.clear();
+        shopKeys_.clear();
+        changed_.clear();
+    }
+    return *this;
+}
+
+// cheia unei cladiri e identificatorul ei, nu pozitia sau numele: demolarile nu schimba zarurile
+// celorlalte, iar doua cladiri cu acelasi nume nu primesc aceleasi zaruri
+void CityEvents::rebuild(const std::vector<std::shared_ptr<Building>>& buildings, const std::vector<std::uint64_t>& keys) {
+    utilities_.clear();
+    utilityKeys_.clear();
+    shops_.clear();
+    shopKeys_.clear();
+    for (std::size_t i = 0; i < buildings.size(); ++i) {
+        if (auto* u = dynamic_cast<UtilityBuilding*>(buildings[i].get())) {
+            utilities_.push_back(u);
+            utilityKeys_.push_back(keys[i]);
+        } else if (auto* c = dynamic_cast<CommercialBuilding*>(buildings[i].get())) {
+            shops_.push_back(c);
+            shopKeys_.push_back(keys[i]);
+        }
+    }
+}
+
+void CityEvents::rollAll(std::uint32_t stream, std::uint64_t tick, const std::vector<std::uint64_t>& keys, std::vector<std::uint64_t>& out) const {
+    out.resize(keys.size());
+    rng_.fill(stream, tick, keys.data(), out.data(), keys.size());
+}
+
+double CityEvents::between(std::uint64_t bits, double lo, double hi) const noexcept {
+    return lo + (hi - lo) * (static_cast<double>(bits >> 11) * 0x1.0p-53);
+}
+
+// intai expira efectele vechi, apoi se arunca zarurile pentru cladirile neafectate
+EventOutcome CityEvents::evaluate(std::uint64_t tick, const std::map<std::string, int>& resources) {
+    EventOutcome out;
+    changed_.clear();
+
+    const std::uint64_t failAt = CounterRng::threshold(config_.utilityFailure);
+    rollAll(UtilityFailure, tick, utilityKeys_, rolls_);
+    for (std::size_t i = 0; i < utilities_.size(); ++i) {
+        UtilityBuilding& u = *utilities_[i];
+        if (u.isOffline()) {
+            if (tick < u.outageUntil()) continue;
+            u.endOutage();
+            ++stats_.repairs;
+            out.services = true;
+            changed_.push_back(&u);
+        } else if (rolls_[i] < failAt) {
+            u.startOutage(tick + static_cast<std::uint64_t>(config_.outageTicks));
+            ++stats_.outages;
+            out.services = true;
+            changed_.push_back(&u);
+        }
+    }
+
+    const std::uint64_t shiftAt = CounterRng::threshold(config_.demandShift);
+    rollAll(DemandShift, tick, shopKeys_, rolls_);
+    rollAll(DemandLevel, tick, shopKeys_, levels_);
+    for (std::size_t i = 0; i < shops_.size(); ++i) {
+        CommercialBuilding& c = *shops_[i];
+        if (c.demandUntil() != 0) {
+            if (tick < c.demandUntil()) continue;
+            c.setDemand(1.0, 0);
+            out.services = true;
+            changed_.push_back(&c);
+        } else if (rolls_[i] < shiftAt) {
+            c.setDemand(between(levels_[i], config_.demandMin, config_.demandMax), tick + static_cast<std::uint64_t>(config_.demandTicks));
+            ++stats_.demandShifts;
+            out.services = true;
+            changed_.push_back(&c);
+        }
+    }
+
+    // putine resurse, deci fara coloane
+    for (auto it = prices_.begin(); it != prices_.end();) {
+        if (tick < it->second.until) {
+            ++it;
+            continue;
+        }
+        it = prices_.erase(it);
+        out.prices = true;
+    }
+    const std::uint64_t shockAt = CounterRng::threshold(config_.priceShock);
+    for (const auto& kv : resources) {
+        if (prices_.contains(kv.first)) continue;
+        // resursele nu au identificator; numele e cheia lor unica in stoc
+        const std::uint64_t key = CounterRng::key(kv.first);
+        if (rng_.bits(PriceShock, tick, key) >= shockAt) continue;
+        const double factor = between(rng_.bits(PriceLevel, tick, key), config_.priceMin, config_.priceMax);
+        prices_.emplace(kv.first, PriceState{factor, tick + static_cast<std::uint64_t>(config_.priceTicks)});
+        ++stats_.priceShocks;
+        out.prices = true;
+    }
+    return out;
+}
+
+void CityEvents::setSeed(std::uint64_t seed) noexcept {
+    rng_.seed = seed;
+}
+
+std::uint64_t CityEvents::seed() const noexcept {
+    return rng_.seed;
+}
+
+const EventConfig& CityEvents::config() const noexcept {
+    return config_;
+}
+
+const EventStats& CityEvents::stats() const noexcept {
+    return stats_;
+}
+
+const std::vector<Building*>& CityEvents::changed() const noexcept {
+    return changed_;
+}
+
+double CityEvents::price(const std::string& resource) const {
+    auto it = prices_.find(resource);
+    return it == prices_.end() ? 1.0 : it->second.factor;
+}
+
+std::size_t CityEvents::memoryUsage() const noexcept {
+    return sizeof(*this) + mapMemory(prices_)
+         + utilities_.capacity() * sizeof(UtilityBuilding*) + shops_.capacity() * sizeof(CommercialBuilding*)
+         + changed_.capacity() * sizeof(Building*)
+         + (utilityKeys_.capacity() + shopKeys_.capacity() + rolls_.capacity() + levels_.capacity()) * sizeof(std::uint64_t);
+}
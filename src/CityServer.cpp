@@ -0,0 +1,434 @@
+#include "../include/CityServer.hpp"
+#include "../include/AutoSave.hpp"
+#include "../include/BuildingCatalog.hpp"
+#include "../include/City.hpp"
+#include "../include/Exceptions.hpp"
+#include "../include/Street.hpp"
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CITY_SERVER_POSIX 1
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+class WireReader {
+    std::string_view data_;
+    std::size_t pos_ = 0;
+
+    std::uint64_t read(std::size_t bytes) {
+        if (data_.size() - pos_ < bytes) throw CityException("Malformed request");
+        std::uint64_t v = 0;
+        for (std::size_t i = 0; i < bytes; ++i)
+            v |= std::uint64_t{static_cast<unsigned char>(data_[pos_ + i])} << (8 * i);
+        pos_ += bytes;
+        return v;
+    }
+
+public:
+    explicit WireReader(std::string_view data) : data_(data) {}
+
+    std::uint8_t u8() { return static_cast<std::uint8_t>(read(1)); }
+    std::uint32_t u32() { return static_cast<std::uint32_t>(read(4)); }
+    std::int64_t i64() { return static_cast<std::int64_t>(read(8)); }
+
+    std::string str() {
+        const std::size_t n = static_cast<std::size_t>(read(2));
+        if (data_.size() - pos_ < n) throw CityException("Malformed request");
+        std::string s(data_.substr(pos_, n));
+        pos_ += n;
+        return s;
+    }
+};
+
+class WireWriter {
+    std::string& out_;
+
+    void write(std::uint64_t v, std::size_t bytes) {
+        for (std::size_t i = 0; i < bytes; ++i) out_.push_back(static_cast<char>((v >> (8 * i)) & 0xFFu));
+    }
+
+public:
+    explicit WireWriter(std::string& out) : out_(out) {}
+
+    void u8(std::uint8_t v) { write(v, 1); }
+    void u32(std::uint32_t v) { write(v, 4); }
+    void u64(std::uint64_t v) { write(v, 8); }
+    void i32(std::int32_t v) { write(static_cast<std::uint32_t>(v), 4); }
+    void i64(std::int64_t v) { write(static_cast<std::uint64_t>(v), 8); }
+    void str(std::string_view s) {
+        s = s.substr(0, 0xFFFFu);
+        write(s.size(), 2);
+        out_.append(s);
+    }
+    void blob(std::string_view s) {
+        write(s.size(), 4);
+        out_.append(s);
+    }
+};
+
+// valorile i64 de pe fir care ajung in campuri int sunt verificate, nu trunchiate
+int narrow(std::int64_t v) {
+    if (v < std::numeric_limits<int>::min() || v > std::numeric_limits<int>::max())
+        throw CityException("Value out of range: " + std::to_string(v));
+    return static_cast<int>(v);
+}
+
+// lungimea cadrului se completeaza dupa ce raspunsul e scris
+void patchLength(std::string& out, std::size_t at) {
+    const auto len = static_cast<std::uint32_t>(out.size() - at - 4);
+    for (std::size_t i = 0; i < 4; ++i) out[at + i] = static_cast<char>((len >> (8 * i)) & 0xFFu);
+}
+
+}
+
+CityServer::CityServer(std::string socketPath) : socketPath_(std::move(socketPath)) {}
+
+CityServer::~CityServer() = default;
+
+CityServer::Resident& CityServer::resident(std::uint32_t id) {
+    auto it = cities_.find(id);
+    if (it == cities_.end()) throw CityException("Unknown city id: " + std::to_string(id));
+    return it->second;
+}
+
+void CityServer::execute(ServerOp op, std::string_view args, std::string& out) {
+    WireReader in(args);
+    WireWriter w(out);
+    switch (op) {
+        case ServerOp::CreateCity: {
+            std::string name = in.str();
+            const Money money = in.i64();
+            const std::uint32_t id = nextCity_++;
+            cities_[id].city = std::make_unique<City>(std::move(name), money);
+            w.u32(id);
+            break;
+        }
+        case ServerOp::DropCity:
+            if (cities_.erase(in.u32()) == 0) throw CityException("Unknown city id");
+            break;
+        case ServerOp::AddStreet: {
+            City& city = *resident(in.u32()).city;
+            Street st(in.u8());
+            const int segments = in.u8();
+            for (int s = 0; s < segments; ++s) st.addSegment(s + 1);
+            city.addStreet(st);
+            w.u32(static_cast<std::uint32_t>(city.streetCount() - 1));
+            break;
+        }
+        case ServerOp::AddResource: {
+            City& city = *resident(in.u32()).city;
+            std::string name = in.str();
+            city.addResource(name, narrow(in.i64()));
+            break;
+        }
+        case ServerOp::AddBuilding: {
+            Resident& r = resident(in.u32());
+            std::string type = in.str();
+            std::string name = in.str();
+            const std::uint32_t street = in.u32();
+            std::vector<std::string> params(in.u8());
+            for (auto& p : params) p = in.str();
+            const BuildingId id = r.city->addBuilding(type, name, params, street);
+            r.columnsDirty = true;
+            w.u32(id.index);
+            w.u32(id.generation);
+            break;
+        }
+        case ServerOp::Tick: {
+            Resident& r = resident(in.u32());
+            const std::uint32_t n = in.u32();
+            if (n > MAX_TICKS) throw CityException("Too many ticks in one request: " + std::to_string(n));
+            // un fisier de catalog modificat intra in vigoare la urmatorul tick; unul gresit
+            // e raportat o singura data, iar orasele merg mai departe pe tabelele anterioare
+            try {
+                BuildingCatalog::instance().reloadIfChanged();
+            } catch (const std::exception& e) {
+                std::cerr << "Catalog reload failed: " << e.what() << '\n';
+            }
+            for (std::uint32_t t = 0; t < n; ++t) r.city->tick();
+            r.columnsDirty = true;
+            w.u64(r.city->currentTick());
+            w.i64(r.city->money());
+            break;
+        }
+        case ServerOp::Query: {
+            Resident& r = resident(in.u32());
+            BuildingQuery q;
+            const int preds = in.u8();
+            for (int i = 0; i < preds; ++i) {
+                const auto lhs = static_cast<Column>(in.u8());
+                const auto cmp = static_cast<CompareOp>(in.u8());
+                if (lhs > Column::Capacity || cmp > CompareOp::Ge) throw CityException("Invalid query predicate");
+                if (in.u8()) {
+                    const auto rhs = static_cast<Column>(in.u8());
+                    if (rhs > Column::Capacity) throw CityException("Invalid query predicate");
+                    q.where(lhs, cmp, rhs);
+                } else {
+                    q.where(lhs, cmp, static_cast<long long>(in.i64()));
+                }
+            }
+            q.groupBy(in.u8() & (GroupKind | GroupStreet | GroupLevel));
+            const auto value = static_cast<Column>(in.u8());
+            if (value > Column::Capacity) throw CityException("Invalid query column");
+            q.aggregate(value);
+            if (r.columnsDirty) {
+                r.columns = r.city->columns();
+                r.columnsDirty = false;
+            }
+            // orasele servite sunt mici, un singur fir raspunde mai repede decat pornirea altora
+            const std::vector<QueryRow> rows = q.run(r.columns, 1);
+            w.u32(static_cast<std::uint32_t>(rows.size()));
+            for (const auto& row : rows) {
+                w.i32(row.kind);
+                w.i32(row.level);
+                w.i64(row.street);
+                w.u64(row.count);
+                w.i64(row.sum);
+                w.i64(row.min);
+                w.i64(row.max);
+            }
+            break;
+        }
+        case ServerOp::Summary: {
+            const City& city = *resident(in.u32()).city;
+            w.i64(city.money());
+            w.u64(city.currentTick());
+            w.u32(static_cast<std::uint32_t>(city.buildingTotal()));
+            w.u32(static_cast<std::uint32_t>(city.remainingSlots()));
+            w.i64(city.totalCapacity());
+            break;
+        }
+        case ServerOp::Snapshot: {
+            std::ostringstream text;
+            writeSnapshot(text, resident(in.u32()).city->snapshot());
+            w.blob(text.str());
+            break;
+        }
+        case ServerOp::Shutdown:
+            running_ = false;
+            break;
+        case ServerOp::ReloadCatalog: {
+            const std::string path = in.str();
+            bool reloaded = true;
+            if (path.empty()) reloaded = BuildingCatalog::instance().reloadIfChanged();
+            else BuildingCatalog::instance().load(path);
+            w.u8(reloaded ? 1 : 0);
+            break;
+        }
+        case ServerOp::Demolish: {
+            Resident& r = resident(in.u32());
+            BuildingId id;
+            id.index = in.u32();
+            id.generation = in.u32();
+            r.city->demolishBuilding(id);
+            r.columnsDirty = true;
+            break;
+        }
+        case ServerOp::WidenStreet: {
+            City& city = *resident(in.u32()).city;
+            const std::uint32_t street = in.u32();
+            city.widenStreet(street);
+            w.u8(static_cast<std::uint8_t>(city.getStreet(street)->level()));
+            break;
+        }
+        case ServerOp::ExtendStreet: {
+            City& city = *resident(in.u32()).city;
+            const std::uint32_t street = in.u32();
+            const std::uint32_t n = in.u32();
+            for (std::uint32_t s = 0; s < n; ++s)
+                if (!city.extendStreet(street, static_cast<int>(s + 1))) throw LimitExceededException();
+            w.u32(static_cast<std::uint32_t>(city.getStreet(street)->slotCount()));
+            break;
+        }
+        default:
+            throw CityException("Unknown server operation: " + std::to_string(static_cast<int>(op)));
+    }
+}
+
+// erorile unei comenzi devin raspunsuri cu stare 1; doar un cadru invalid opreste conexiunea
+std::size_t CityServer::process(std::string_view in, std::string& out) {
+    std::size_t pos = 0;
+    while (in.size() - pos >= 4 && out.size() < MAX_PENDING_OUTPUT) {
+        WireReader header(in.substr(pos, 4));
+        const std::size_t len = header.u32();
+        if (len > MAX_FRAME) throw CityException("Request frame too large");
+        if (len < 5) throw CityException("Malformed request");
+        if (in.size() - pos - 4 < len) break;
+
+        WireReader frame(in.substr(pos + 4, 5));
+        const std::uint32_t id = frame.u32();
+        const auto op = static_cast<ServerOp>(frame.u8());
+
+        const std::size_t at = out.size();
+        WireWriter w(out);
+        w.u32(0);
+        w.u32(id);
+        w.u8(0);
+        try {
+            execute(op, in.substr(pos + 9, len - 5), out);
+        } catch (const std::exception& e) {
+            out.resize(at + 8);
+            w.u8(1);
+            w.str(e.what());
+        }
+        patchLength(out, at);
+        pos += 4 + len;
+    }
+    return pos;
+}
+
+bool CityServer::running() const noexcept {
+    return running_;
+}
+
+#ifdef CITY_SERVER_POSIX
+
+namespace {
+
+[[noreturn]] void throwSystem(const std::string& what) {
+    throw CityException("Server: " + what + ": " + std::strerror(errno));
+}
+
+struct Client {
+    int fd = -1;
+    std::string in;
+    std::string out;
+    std::size_t sent = 0;
+    bool eof = false;   // clientul a inchis scrierea; raspunsurile ramase se trimit inainte de inchidere
+};
+
+}
+
+// un singur fir cu poll: fiecare citire poate aduce mai multe cereri, toate raspunsurile
+// lotului pleaca intr-o singura scriere
+void CityServer::run() {
+    std::signal(SIGPIPE, SIG_IGN);
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socketPath_.size() >= sizeof(addr.sun_path)) throw CityException("Server: socket path too long");
+    std::memcpy(addr.sun_path, socketPath_.c_str(), socketPath_.size() + 1);
+
+    const int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) throwSystem("socket");
+    ::unlink(socketPath_.c_str());
+    if (::bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        ::close(listener);
+        throwSystem("bind " + socketPath_);
+    }
+    if (::listen(listener, 16) < 0) {
+        ::close(listener);
+        throwSystem("listen");
+    }
+    ::fcntl(listener, F_SETFL, ::fcntl(listener, F_GETFL) | O_NONBLOCK);
+
+    std::vector<Client> clients;
+    std::vector<pollfd> fds;
+    char buf[1 << 16];
+    running_ = true;
+
+    while (running_) {
+        fds.clear();
+        fds.push_back({listener, POLLIN, 0});
+        for (const auto& c : clients) {
+            // un client cu prea multe raspunsuri netrimise nu mai e citit pana nu le preia
+            const bool reading = !c.eof && c.out.size() < MAX_PENDING_OUTPUT && c.in.size() < MAX_FRAME + 4;
+            fds.push_back({c.fd, static_cast<short>((reading ? POLLIN : 0) | (c.sent < c.out.size() ? POLLOUT : 0)), 0});
+        }
+        if (::poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            throwSystem("poll");
+        }
+
+        if (fds[0].revents & POLLIN) {
+            for (int fd; (fd = ::accept(listener, nullptr, nullptr)) >= 0;) {
+                ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+                clients.push_back({fd, {}, {}, 0});
+            }
+        }
+
+        for (std::size_t i = 0; i < clients.size(); ++i) {
+            Client& c = clients[i];
+            const short ev = fds.size() > i + 1 ? fds[i + 1].revents : 0;
+            bool closed = false;
+
+            if (!c.eof && (ev & (POLLIN | POLLHUP | POLLERR))) {
+                while (c.in.size() < MAX_FRAME + 4) {
+                    const ssize_t n = ::read(c.fd, buf, sizeof(buf));
+                    if (n > 0) {
+                        c.in.append(buf, static_cast<std::size_t>(n));
+                        continue;
+                    }
+                    if (n == 0) c.eof = true;
+                    else if (errno == EINTR) continue;
+                    else if (errno != EAGAIN && errno != EWOULDBLOCK) closed = true;
+                    break;
+                }
+            }
+            // raspunsurile unui client sunt limitate la MAX_PENDING_OUTPUT (plus cel mult un raspuns);
+            // cererile ramase sunt procesate pe masura ce iesirea se goleste
+            for (;;) {
+                std::size_t consumed = 0;
+                if (!closed && c.out.size() < MAX_PENDING_OUTPUT) {
+                    try {
+                        consumed = process(c.in, c.out);
+                        c.in.erase(0, consumed);
+                    } catch (const CityException&) {
+                        closed = true;
+                    }
+                }
+
+                while (!closed && c.sent < c.out.size()) {
+                    const ssize_t n = ::write(c.fd, c.out.data() + c.sent, c.out.size() - c.sent);
+                    if (n > 0) {
+                        c.sent += static_cast<std::size_t>(n);
+                    } else if (n < 0 && errno == EINTR) {
+                        continue;
+                    } else {
+                        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) closed = true;
+                        break;
+                    }
+                }
+                if (c.sent == c.out.size()) {
+                    c.out.clear();
+                    c.sent = 0;
+                }
+                if (closed || !c.out.empty() || consumed == 0) break;
+            }
+            // dupa EOF conexiunea se inchide abia cand toate raspunsurile au plecat
+            if (c.eof && c.out.empty()) closed = true;
+
+            if (closed) {
+                ::close(c.fd);
+                clients.erase(clients.begin() + static_cast<std::ptrdiff_t>(i));
+                fds.erase(fds.begin() + static_cast<std::ptrdiff_t>(i + 1));
+                --i;
+            }
+        }
+    }
+
+    for (auto& c : clients) ::close(c.fd);
+    ::close(listener);
+    ::unlink(socketPath_.c_str());
+}
+
+#else
+
+void CityServer::run() {
+    throw CityException("Server mode needs Unix domain sockets");
+}
+
+#endif
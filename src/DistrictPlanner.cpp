@@ -0,0 +1,211 @@
+#include "../include/DistrictPlanner.hpp"
+#include "../include/Exceptions.hpp"
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <thread>
+
+namespace {
+
+// optiune pregatita pentru cautare: materialele sunt mapate pe indici densi
+struct Candidate {
+    std::size_t option;
+    int value;
+    int money;
+    std::vector<int> need;
+};
+
+struct SearchShared {
+    const std::vector<Candidate>& cands;
+    const std::vector<double>& bestRatio;
+    const std::vector<std::vector<double>>& matRatio;   // [k][r]: cea mai buna valoare/unitate de material r pe sufix
+    std::chrono::steady_clock::time_point deadline;
+    std::atomic<int> best{-1};
+    std::atomic<bool> timedOut{false};
+};
+
+class Worker {
+    SearchShared& sh_;
+    std::vector<int> counts_;
+    Money money_;
+    std::vector<int> stock_;
+
+public:
+    std::vector<int> bestCounts;
+    int bestScore = -1;
+    std::size_t nodes = 0;
+
+    Worker(SearchShared& sh, Money money, std::vector<int> stock)
+        : sh_(sh), counts_(sh.cands.size(), 0), money_(money), stock_(std::move(stock)) {}
+
+    // cate bucati din candidatul k incap in bugetul ramas
+    [[nodiscard]] std::size_t maxCount(std::size_t k, std::size_t remaining) const {
+        const Candidate& c = sh_.cands[k];
+        std::size_t m = remaining;
+        if (c.money > 0) m = std::min(m, static_cast<std::size_t>(std::max<Money>(0, money_) / c.money));
+        for (std::size_t r = 0; r < c.need.size(); ++r)
+            if (c.need[r] > 0) m = std::min(m, static_cast<std::size_t>(std::max(0, stock_[r]) / c.need[r]));
+        return m;
+    }
+
+    void apply(std::size_t k, int count, int sign) {
+        const Candidate& c = sh_.cands[k];
+        money_ -= sign * count * c.money;
+        for (std::size_t r = 0; r < c.need.size(); ++r) stock_[r] -= sign * count * c.need[r];
+        counts_[k] = sign > 0 ? count : 0;
+    }
+
+    void record(int score) {
+        if (score <= bestScore) return;
+        bestScore = score;
+        bestCounts = counts_;
+        int cur = sh_.best.load(std::memory_order_relaxed);
+        while (score > cur && !sh_.best.compare_exchange_weak(cur, score, std::memory_order_relaxed)) {}
+    }
+
+    // branch and bound pe numarul de bucati din fiecare candidat (sortati descrescator dupa valoare)
+    void search(std::size_t k, std::size_t remaining, int score) {
+        if ((++nodes & 1023u) == 0 && std::chrono::steady_clock::now() >= sh_.deadline)
+            sh_.timedOut.store(true, std::memory_order_relaxed);
+        if (sh_.timedOut.load(std::memory_order_relaxed)) return;
+
+        record(score);
+        if (k == sh_.cands.size() || remaining == 0) return;
+
+        // marginea superioara: toate sloturile ramase cu cea mai buna valoare, limitata de bani
+        // si de stocul fiecarui material
+        long long bound = score + static_cast<long long>(remaining) * sh_.cands[k].value;
+        if (sh_.bestRatio[k] < std::numeric_limits<double>::infinity())
+            bound = std::min(bound, score + static_cast<long long>(static_cast<double>(std::max<Money>(0, money_)) * sh_.bestRatio[k]));
+        for (std::size_t r = 0; r < stock_.size(); ++r)
+            if (sh_.matRatio[k][r] < std::numeric_limits<double>::infinity())
+                bound = std::min(bound, score + static_cast<long long>(static_cast<double>(std::max(0, stock_[r])) * sh_.matRatio[k][r]));
+        if (bound <= sh_.best.load(std::memory_order_relaxed)) return;
+
+        const auto top = static_cast<int>(maxCount(k, remaining));
+        for (int c = top; c >= 0; --c) {
+            apply(k, c, +1);
+            search(k + 1, remaining - static_cast<std::size_t>(c), score + c * sh_.cands[k].value);
+            apply(k, c, -1);
+        }
+    }
+
+    void searchFrom(int firstCount, std::size_t slots) {
+        apply(0, firstCount, +1);
+        search(1, slots - static_cast<std::size_t>(firstCount), firstCount * sh_.cands[0].value);
+        apply(0, firstCount, -1);
+    }
+};
+
+}
+
+DistrictPlanner::DistrictPlanner(std::vector<PlotOption> options) : options_(std::move(options)) {
+    for (const auto& o : options_) {
+        if (o.moneyCost < 0) throw CityException("Plot option cost must be non-negative");
+        for (const auto& kv : o.materials)
+            if (kv.second < 0) throw CityException("Plot option materials must be non-negative");
+    }
+}
+
+DistrictPlan DistrictPlanner::plan(std::size_t slots, Money money, const ResourcePool<int>& materials, PlanGoal goal, std::chrono::milliseconds timeLimit, unsigned threads) const {
+    // indici densi pentru materiale, ca evaluarea sa nu caute in map
+    std::map<std::string, std::size_t> matIdx;
+    for (const auto& o : options_)
+        for (const auto& kv : o.materials) matIdx.emplace(kv.first, matIdx.size());
+
+    std::vector<int> stock(matIdx.size(), 0);
+    for (const auto& kv : matIdx) stock[kv.second] = materials.get(kv.first);
+
+    std::vector<Candidate> cands;
+    for (std::size_t i = 0; i < options_.size(); ++i) {
+        const PlotOption& o = options_[i];
+        int value = goal == PlanGoal::Capacity ? o.capacity : o.income;
+        if (value <= 0) continue;
+        Candidate c{i, value, o.moneyCost, std::vector<int>(matIdx.size(), 0)};
+        for (const auto& kv : o.materials) c.need[matIdx[kv.first]] = kv.second;
+        cands.push_back(std::move(c));
+    }
+    std::ranges::stable_sort(cands, std::greater<>{}, &Candidate::value);
+
+    // cel mai bun raport valoare/bani pe sufix; infinit daca exista o optiune gratuita
+    std::vector<double> bestRatio(cands.size() + 1, 0.0);
+    for (std::size_t k = cands.size(); k-- > 0;) {
+        double r = cands[k].money > 0 ? static_cast<double>(cands[k].value) / cands[k].money
+                                      : std::numeric_limits<double>::infinity();
+        bestRatio[k] = std::max(r, bestRatio[k + 1]);
+    }
+    // la fel pentru fiecare material; infinit daca o optiune din sufix nu il foloseste
+    std::vector<std::vector<double>> matRatio(cands.size() + 1, std::vector<double>(matIdx.size(), 0.0));
+    for (std::size_t k = cands.size(); k-- > 0;) {
+        for (std::size_t r = 0; r < matIdx.size(); ++r) {
+            double q = cands[k].need[r] > 0 ? static_cast<double>(cands[k].value) / cands[k].need[r]
+                                            : std::numeric_limits<double>::infinity();
+            matRatio[k][r] = std::max(q, matRatio[k + 1][r]);
+        }
+    }
+
+    DistrictPlan result;
+    result.choice.assign(slots, DistrictPlan::EMPTY);
+    if (cands.empty() || slots == 0) {
+        result.exhaustive = true;
+        return result;
+    }
+
+    SearchShared shared{cands, bestRatio, matRatio, std::chrono::steady_clock::now() + timeLimit};
+
+    // ramurile de pe primul nivel sunt impartite intre fire
+    const auto firstMax = static_cast<int>(Worker(shared, money, stock).maxCount(0, slots));
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min<unsigned>(threads, static_cast<unsigned>(firstMax) + 1);
+
+    std::atomic<int> nextBranch{0};
+    std::vector<Worker> workers(threads, Worker(shared, money, stock));
+    std::vector<std::thread> pool;
+    pool.reserve(threads);
+    for (unsigned t = 0; t < threads; ++t) {
+        pool.emplace_back([&, t]() {
+            for (int b = nextBranch++; b <= firstMax; b = nextBranch++)
+                workers[t].searchFrom(firstMax - b, slots);
+        });
+    }
+    for (auto& th : pool) th.join();
+
+    const Worker* best = nullptr;
+    for (const auto& w : workers) {
+        result.nodes += w.nodes;
+        if (!w.bestCounts.empty() && (!best || w.bestScore > best->bestScore)) best = &w;
+    }
+    result.exhaustive = !shared.timedOut.load();
+    if (!best) return result;
+
+    std::size_t pos = 0;
+    for (std::size_t k = 0; k < cands.size(); ++k) {
+        for (int c = 0; c < best->bestCounts[k]; ++c) {
+            result.choice[pos++] = cands[k].option;
+            result.moneyCost += cands[k].money;
+            for (const auto& kv : options_[cands[k].option].materials)
+                if (kv.second > 0) result.materials[kv.first] += kv.second;
+        }
+    }
+    result.score = best->bestScore;
+    return result;
+}
+
+// construieste efectiv cladirile planului, o singura data, dupa cautare
+std::vector<Slot> DistrictPlanner::materialize(const DistrictPlan& plan, const Street* st) const {
+    std::vector<Slot> district;
+    district.reserve(plan.choice.size());
+    for (std::size_t i = 0; i < plan.choice.size(); ++i) {
+        if (plan.choice[i] == DistrictPlan::EMPTY) {
+            district.emplace_back();
+            continue;
+        }
+        const PlotOption& o = options_.at(plan.choice[i]);
+        district.emplace_back(BuildingCreator::instance().create(o.typeId, o.namePrefix + std::to_string(i + 1), o.params, st));
+    }
+    return district;
+}
+
+const std::vector<PlotOption>& DistrictPlanner::options() const noexcept {
+    return options_;
+}
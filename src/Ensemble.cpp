@@ -0,0 +1,123 @@
+#include "../include/Ensemble.hpp"
+#include "../include/City.hpp"
+#include "../include/Exceptions.hpp"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+// cuantila prin nth_element pe o copie a valorilor
+Money quantile(std::vector<Money> values, double q) {
+    if (values.empty()) return 0;
+    const auto k = static_cast<std::size_t>(q * static_cast<double>(values.size() - 1) + 0.5);
+    std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(k), values.end());
+    return values[k];
+}
+
+}
+
+EnsembleRunner::EnsembleRunner(std::size_t replicas, std::uint64_t ticks, std::uint64_t seed)
+    : replicas_(replicas), ticks_(ticks), seed_(seed) {
+    if (replicas_ == 0) throw CityException("Ensemble needs at least one replica");
+}
+
+EnsembleRunner& EnsembleRunner::addPolicy(EnsemblePolicy policy) {
+    policies_.push_back(std::move(policy));
+    return *this;
+}
+
+std::uint64_t EnsembleRunner::replicaSeed(std::size_t replica) const noexcept {
+    return CounterRng{seed_}.bits(0, 0, replica);
+}
+
+ReplicaResult EnsembleRunner::runReplica(const City& base, std::size_t replica) const {
+    ReplicaResult r;
+    r.replica = replica;
+    r.policy = replica % policies_.size();
+    r.seed = replicaSeed(replica);
+    const EnsemblePolicy& policy = policies_[r.policy];
+
+    City city(base);
+    city.setMetricsEnabled(false);
+    city.setWorkerThreads(1);   // paralelismul e intre replici
+    city.setErrorHandler([&r](const Building&, const CityException& e) {
+        if (dynamic_cast<const InsufficientResourceException*>(&e)) ++r.shortfalls;
+        else ++r.failures;
+    });
+    city.enableEvents(policy.events, r.seed);
+    if (policy.subsidy != 0) city.transfer(policy.subsidy, Account::Capital, "subsidy");
+
+    r.minMoney = city.money();
+    for (std::uint64_t t = 0; t < ticks_; ++t) {
+        city.tick();
+        r.minMoney = std::min(r.minMoney, city.money());
+    }
+    r.finalMoney = city.money();
+    r.finalCapacity = city.totalCapacity();
+    r.outages = city.events()->stats().outages;
+    return r;
+}
+
+std::vector<PolicySummary> EnsembleRunner::run(const City& base, const ResultHandler& onResult, unsigned threads) const {
+    if (policies_.empty()) return EnsembleRunner(*this).addPolicy({}).run(base, onResult, threads);
+
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, replicas_));
+
+    std::vector<ReplicaResult> results(replicas_);
+    std::atomic<std::size_t> next{0};
+    std::mutex mutex;
+    std::exception_ptr error;
+    std::vector<std::thread> pool;
+    pool.reserve(threads);
+    for (unsigned t = 0; t < threads; ++t) {
+        pool.emplace_back([&]() {
+            for (std::size_t i = next++; i < replicas_; i = next++) {
+                try {
+                    results[i] = runReplica(base, i);
+                    if (onResult) {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        onResult(results[i]);
+                    }
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!error) error = std::current_exception();
+                    next = replicas_;
+                }
+            }
+        });
+    }
+    for (auto& th : pool) th.join();
+    if (error) std::rethrow_exception(error);
+
+    std::vector<PolicySummary> summaries(policies_.size());
+    for (std::size_t p = 0; p < policies_.size(); ++p) {
+        PolicySummary& s = summaries[p];
+        s.policy = policies_[p].name;
+        std::vector<Money> money;
+        std::size_t withShortfall = 0;
+        for (std::size_t i = p; i < replicas_; i += policies_.size()) {
+            const ReplicaResult& r = results[i];
+            money.push_back(r.finalMoney);
+            s.worstMoney = s.replicas == 0 ? r.minMoney : std::min(s.worstMoney, r.minMoney);
+            s.meanMoney += static_cast<double>(r.finalMoney);
+            s.meanShortfalls += static_cast<double>(r.shortfalls);
+            s.meanCapacity += static_cast<double>(r.finalCapacity);
+            if (r.shortfalls > 0) ++withShortfall;
+            ++s.replicas;
+        }
+        if (s.replicas == 0) continue;
+        const auto n = static_cast<double>(s.replicas);
+        s.meanMoney /= n;
+        s.meanShortfalls /= n;
+        s.meanCapacity /= n;
+        s.shortfallRate = static_cast<double>(withShortfall) / n;
+        s.moneyP05 = quantile(money, 0.05);
+        s.moneyP50 = quantile(money, 0.50);
+        s.moneyP95 = quantile(std::move(money), 0.95);
+    }
+    return summaries;
+}
@@ -1,4 +1,5 @@
 #include "../include/Factory.hpp"
+#include "../include/BuildingCatalog.hpp"
 
 
 namespace {
@@ -8,17 +9,23 @@ namespace {
             "factory",
             [](const std::string& name,
                const std::vector<std::string>& params,
-               Street* st) -> std::shared_ptr<Building>
+               const Street* st) -> std::shared_ptr<Building>
             {
                 // parametrii:
                 // [0] = nume resursa
                 // [1] = cantitate
                 // [2] = cost per productie
-                std::string resName = !params.empty() ? params[0]:"wood";
-                int amount = params.size() > 1 ? std::stoi(params[1]) : 5;
-                int cost = params.size() > 2 ? std::stoi(params[2]) : 20;
+                // [3..] = perechi (resursa consumata, cantitate)
+                auto tables = BuildingCatalog::instance().current();
+                const FactoryTuning& t = *tables->factory;
+                std::string resName = !params.empty() ? params[0] : t.defaultResource;
+                int amount = params.size() > 1 ? std::stoi(params[1]) : t.defaultAmount;
+                int cost = params.size() > 2 ? std::stoi(params[2]) : t.defaultCost;
                 std::map<std::string,int> prod{{resName, amount}};
-                return std::make_shared<FactoryBuilding>(name, prod, cost, st);
+                std::map<std::string,int> inputs;
+                for (std::size_t i = 3; i + 1 < params.size(); i += 2)
+                    inputs[params[i]] += std::stoi(params[i + 1]);
+                return std::make_shared<FactoryBuilding>(name, prod, cost, st, inputs);
             }
         );
         return true;
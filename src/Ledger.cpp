@@ -0,0 +1,188 @@
+#include "../include/Ledger.hpp"
+#include "../include/Exceptions.hpp"
+#include "../include/NamePool.hpp"
+#include <charconv>
+#include <sstream>
+#include <utility>
+
+namespace {
+
+constexpr std::array<const char*, ACCOUNT_COUNT> ACCOUNT_NAMES{
+    "treasury", "capital", "upgrade_income", "upgrade_expense", "factory_expense", "park_purchase", "administration",
+    "construction"};
+
+template <typename T>
+void appendNumber(std::string& out, T value) {
+    char buf[24];
+    auto res = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, res.ptr);
+}
+
+template <typename T>
+bool parseNumber(std::string_view s, T& value) {
+    auto res = std::from_chars(s.data(), s.data() + s.size(), value);
+    return res.ec == std::errc{} && res.ptr == s.data() + s.size();
+}
+
+// memo-ul e ultimul camp al liniei: spatiile, controalele si '%' devin %XX, iar un memo
+// care e chiar "-" se scrie %2D ca sa nu se confunde cu lipsa memo-ului
+void appendMemo(std::string& out, std::string_view memo) {
+    constexpr char HEX[] = "0123456789ABCDEF";
+    if (memo == "-") {
+        out += "%2D";
+        return;
+    }
+    for (const char ch : memo) {
+        const auto c = static_cast<unsigned char>(ch);
+        if (c <= ' ' || c == '%' || c == 0x7F) {
+            out += '%';
+            out += HEX[c >> 4];
+            out += HEX[c & 0xF];
+        } else {
+            out += ch;
+        }
+    }
+}
+
+bool decodeMemo(std::string_view field, std::string& memo) {
+    memo.clear();
+    for (std::size_t i = 0; i < field.size(); ++i) {
+        if (field[i] != '%') {
+            memo += field[i];
+            continue;
+        }
+        unsigned value = 0;
+        if (i + 2 >= field.size()) return false;
+        auto res = std::from_chars(field.data() + i + 1, field.data() + i + 3, value, 16);
+        if (res.ec != std::errc{} || res.ptr != field.data() + i + 3) return false;
+        memo += static_cast<char>(value);
+        i += 2;
+    }
+    return true;
+}
+
+}
+
+const char* accountName(Account a) noexcept {
+    return ACCOUNT_NAMES[static_cast<std::size_t>(a)];
+}
+
+std::optional<Account> accountFromName(std::string_view name) noexcept {
+    for (std::size_t i = 0; i < ACCOUNT_NAMES.size(); ++i)
+        if (name == ACCOUNT_NAMES[i]) return static_cast<Account>(i);
+    return std::nullopt;
+}
+
+Ledger::Ledger(const Ledger& other)
+    : balances_(other.balances_), batch_(other.batch_), tick_(other.tick_),
+      nextSeq_(other.nextSeq_), committed_(other.committed_) {}
+
+Ledger::~Ledger() {
+    try {
+        commit();
+    } catch (...) {
+        // nu aruncam din destructor; ultimul lot se pierde doar daca discul refuza scrierea
+    }
+}
+
+void Ledger::post(Account debit, Account credit, Money amount, NameRef memo) {
+    if (amount < 0) throw CityException("Ledger amount must not be negative");
+    if (amount == 0 || debit == credit) return;
+    batch_.push_back(LedgerEntry{tick_, nextSeq_++, std::move(memo), amount, debit, credit});
+    balances_[static_cast<std::size_t>(debit)] += amount;
+    balances_[static_cast<std::size_t>(credit)] -= amount;
+}
+
+void Ledger::setTick(std::uint64_t tick) noexcept {
+    tick_ = tick;
+}
+
+void Ledger::openLog(const std::string& path, bool truncate) {
+    std::ofstream out(path, truncate ? std::ios::trunc : std::ios::app);
+    if (!out) throw CityException("Cannot open ledger log: " + path);
+    log_ = std::move(out);
+    logPath_ = path;
+}
+
+bool Ledger::hasLog() const noexcept {
+    return log_.is_open();
+}
+
+// o linie pe tranzactie: tick seq debit credit suma memo ('-' fara memo, altfel codat cu appendMemo)
+void Ledger::commit() {
+    if (batch_.empty()) return;
+    if (log_.is_open()) {
+        buffer_.clear();
+        for (const LedgerEntry& e : batch_) {
+            appendNumber(buffer_, e.tick);
+            buffer_ += ' ';
+            appendNumber(buffer_, e.seq);
+            buffer_ += ' ';
+            buffer_ += accountName(e.debit);
+            buffer_ += ' ';
+            buffer_ += accountName(e.credit);
+            buffer_ += ' ';
+            appendNumber(buffer_, e.amount);
+            buffer_ += ' ';
+            if (e.memo) appendMemo(buffer_, *e.memo);
+            else buffer_ += '-';
+            buffer_ += '\n';
+        }
+        log_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        log_.flush();
+        if (!log_) throw CityException("Cannot write ledger log: " + logPath_);
+    }
+    committed_ += batch_.size();
+    batch_.clear();
+}
+
+Money Ledger::balance(Account a) const noexcept {
+    return balances_[static_cast<std::size_t>(a)];
+}
+
+std::size_t Ledger::pending() const noexcept {
+    return batch_.size();
+}
+
+std::uint64_t Ledger::committed() const noexcept {
+    return committed_;
+}
+
+const std::vector<LedgerEntry>& Ledger::batch() const noexcept {
+    return batch_;
+}
+
+std::size_t Ledger::memoryUsage() const noexcept {
+    return sizeof(*this) + batch_.capacity() * sizeof(LedgerEntry) + buffer_.capacity() + logPath_.capacity();
+}
+
+std::vector<LedgerEntry> auditLedger(std::istream& in, const LedgerFilter& filter) {
+    std::vector<LedgerEntry> out;
+    std::string line;
+    std::size_t lineNo = 0;
+    while (std::getline(in, line)) {
+        ++lineNo;
+        if (line.empty()) continue;
+        std::istringstream fields(line);
+        std::string tick, seq, debit, credit, amount, memoField, memo;
+        if (!(fields >> tick >> seq >> debit >> credit >> amount >> memoField))
+            throw CityException("Malformed ledger line " + std::to_string(lineNo));
+
+        LedgerEntry e;
+        auto d = accountFromName(debit);
+        auto c = accountFromName(credit);
+        const bool hasMemo = memoField != "-";
+        if (!d || !c || !parseNumber(tick, e.tick) || !parseNumber(seq, e.seq) || !parseNumber(amount, e.amount)
+            || (hasMemo && !decodeMemo(memoField, memo)))
+            throw CityException("Malformed ledger line " + std::to_string(lineNo));
+        e.debit = *d;
+        e.credit = *c;
+
+        if (e.tick < filter.fromTick || e.tick > filter.toTick) continue;
+        if (filter.account && e.debit != *filter.account && e.credit != *filter.account) continue;
+        if (!filter.memo.empty() && (!hasMemo || memo != filter.memo)) continue;
+        if (hasMemo) e.memo = NamePool::instance().intern(memo);
+        out.push_back(e);
+    }
+    return out;
+}
@@ -0,0 +1,78 @@
+#include "../include/NamePool.hpp"
+#include "../include/MemoryUsage.hpp"
+#include <functional>
+#include <mutex>
+
+NamePool& NamePool::instance() {
+    static NamePool inst;
+    return inst;
+}
+
+// cautare sub lacat partajat; doar numele noi iau lacatul exclusiv al bucatii lor.
+// Un nume gasit cu 0 referinte e unul pe care alt fir tocmai il elibereaza: incrementul
+// de aici il pastreaza, pentru ca release verifica din nou contorul sub lacatul exclusiv
+NameRef NamePool::intern(std::string_view name) {
+    const std::size_t s = std::hash<std::string_view>{}(name) % SHARDS;
+    Shard& shard = shards_[s];
+    {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.index.find(name);
+        if (it != shard.index.end()) {
+            it->second->refs.fetch_add(1, std::memory_order_relaxed);
+            return NameRef(it->second);
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.index.find(name);
+    if (it != shard.index.end()) {
+        it->second->refs.fetch_add(1, std::memory_order_relaxed);
+        return NameRef(it->second);
+    }
+    Entry* e;
+    if (shard.free.empty()) {
+        e = &shard.entries.emplace_back();
+        e->shard = s;
+    } else {
+        e = shard.free.back();
+        shard.free.pop_back();
+    }
+    e->name.assign(name);
+    e->refs.store(1, std::memory_order_relaxed);
+    e->live = true;
+    shard.index.emplace(e->name, e);
+    return NameRef(e);
+}
+
+// ultima referinta scoate numele din index; intrarea ramane in bucata pentru refolosire
+void NamePool::release(Entry* e) noexcept {
+    if (e->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+    Shard& shard = shards_[e->shard];
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    if (!e->live || e->refs.load(std::memory_order_relaxed) != 0) return;   // refolosit sau deja eliberat
+    shard.index.erase(e->name);
+    e->live = false;
+    e->name = std::string();
+    shard.free.push_back(e);
+}
+
+std::size_t NamePool::size() const {
+    std::size_t total = 0;
+    for (const auto& shard : shards_) {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        total += shard.index.size();
+    }
+    return total;
+}
+
+// intrari + siruri + noduri de hash (valoare, pointer urmator, hash memorat) + tabela de bucket-uri
+std::size_t NamePool::memoryUsage() const {
+    constexpr std::size_t HASH_NODE = sizeof(std::pair<const std::string_view, Entry*>) + 2 * sizeof(void*);
+    std::size_t total = sizeof(*this);
+    for (const auto& shard : shards_) {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        total += shard.entries.size() * sizeof(Entry) + shard.free.capacity() * sizeof(Entry*);
+        for (const auto& e : shard.entries) total += stringHeap(e.name);
+        total += shard.index.size() * HASH_NODE + shard.index.bucket_count() * sizeof(void*);
+    }
+    return total;
+}
@@ -0,0 +1,153 @@
+#include "../include/ProductionScheduler.hpp"
+#include "../include/Factory.hpp"
+#include "../include/MemoryUsage.hpp"
+#include <algorithm>
+#include <cmath>
+
+std::uint32_t ProductionScheduler::intern(const std::string& name) {
+    auto [it, inserted] = resourceIds_.emplace(name, static_cast<std::uint32_t>(resourceNames_.size()));
+    if (inserted) resourceNames_.push_back(name);
+    return it->second;
+}
+
+// construieste DAG-ul fabrica -> resursa -> fabrica si imparte fabricile pe niveluri (Kahn)
+void ProductionScheduler::rebuild(const std::vector<std::shared_ptr<Building>>& buildings) {
+    resourceNames_.clear();
+    resourceIds_.clear();
+    flows_.clear();
+    jobs_.clear();
+    levelEnd_.clear();
+    blocked_.clear();
+
+    std::vector<std::shared_ptr<FactoryBuilding>> factories;
+    for (const auto& b : buildings)
+        if (auto f = std::dynamic_pointer_cast<FactoryBuilding>(b)) factories.push_back(std::move(f));
+
+    struct Recipe {
+        std::vector<Flow> in, out;
+    };
+    std::vector<Recipe> recipes(factories.size());
+    for (std::size_t i = 0; i < factories.size(); ++i) {
+        for (const auto& kv : factories[i]->inputs()) recipes[i].in.push_back({intern(kv.first), kv.second});
+        for (const auto& kv : factories[i]->outputs()) recipes[i].out.push_back({intern(kv.first), kv.second});
+    }
+
+    // o resursa e gata cand toti producatorii ei au rulat
+    const std::size_t resCount = resourceNames_.size();
+    std::vector<std::vector<std::size_t>> consumers(resCount);
+    std::vector<int> pendingProducers(resCount, 0);
+    std::vector<int> pendingInputs(factories.size(), 0);
+    for (std::size_t i = 0; i < factories.size(); ++i) {
+        for (const Flow& f : recipes[i].in) {
+            consumers[f.res].push_back(i);
+            ++pendingInputs[i];
+        }
+        for (const Flow& f : recipes[i].out) ++pendingProducers[f.res];
+    }
+
+    std::vector<std::size_t> level;
+    for (std::size_t i = 0; i < factories.size(); ++i) {
+        for (const Flow& f : recipes[i].in)
+            if (pendingProducers[f.res] == 0) --pendingInputs[i];
+        if (pendingInputs[i] == 0) level.push_back(i);
+    }
+
+    std::size_t scheduled = 0;
+    while (!level.empty()) {
+        std::vector<std::size_t> next;
+        for (std::size_t i : level) {
+            const std::uint32_t priceRes = recipes[i].out.empty() ? UINT32_MAX : recipes[i].out.front().res;
+            Job job{factories[i], factories[i]->cost(), factories[i]->cost(), priceRes, 0, 0, 0, 0};
+            job.inBegin = static_cast<std::uint32_t>(flows_.size());
+            flows_.insert(flows_.end(), recipes[i].in.begin(), recipes[i].in.end());
+            job.inEnd = job.outBegin = static_cast<std::uint32_t>(flows_.size());
+            flows_.insert(flows_.end(), recipes[i].out.begin(), recipes[i].out.end());
+            job.outEnd = static_cast<std::uint32_t>(flows_.size());
+            jobs_.push_back(std::move(job));
+
+            for (const Flow& f : recipes[i].out) {
+                if (--pendingProducers[f.res] != 0) continue;
+                for (std::size_t c : consumers[f.res])
+                    if (--pendingInputs[c] == 0) next.push_back(c);
+            }
+        }
+        scheduled += level.size();
+        levelEnd_.push_back(jobs_.size());
+        std::ranges::sort(next);
+        level = std::move(next);
+    }
+
+    // ce n-a ajuns pe niciun nivel asteapta o resursa produsa doar intr-un ciclu
+    if (scheduled != factories.size())
+        for (std::size_t i = 0; i < factories.size(); ++i)
+            if (pendingInputs[i] > 0) blocked_.push_back(factories[i]);
+}
+
+void ProductionScheduler::applyPrices(const std::function<double(const std::string&)>& price) {
+    for (Job& job : jobs_) {
+        const double factor = job.priceRes == UINT32_MAX ? 1.0 : price(resourceNames_[job.priceRes]);
+        job.cost = std::max(0, static_cast<int>(std::lround(job.baseCost * factor)));
+    }
+}
+
+// un tick de productie: stocul e citit o data, fiecare nivel e decontat intr-o trecere densa
+void ProductionScheduler::run(ResourcePool<int>& resources, Money& money, Ledger& ledger, ResourcePool<long>& stats, const ErrorHandler& onError) const {
+    const std::size_t resCount = resourceNames_.size();
+    std::vector<long long> start(resCount), stock(resCount), levelOut(resCount, 0), produced(resCount, 0);
+    for (std::size_t r = 0; r < resCount; ++r) start[r] = stock[r] = resources.get(resourceNames_[r]);
+
+    std::size_t begin = 0;
+    for (std::size_t end : levelEnd_) {
+        for (std::size_t j = begin; j < end; ++j) {
+            const Job& job = jobs_[j];
+            bool ok = true;
+            for (std::uint32_t k = job.inBegin; k < job.inEnd && ok; ++k) {
+                if (stock[flows_[k].res] < flows_[k].qty) {
+                    onError(*job.factory, InsufficientResourceException(resourceNames_[flows_[k].res]));
+                    ok = false;
+                }
+            }
+            if (!ok) continue;
+            if (!trySpend(money, job.cost)) {
+                onError(*job.factory, CityException("Not enough money to activate factory production"));
+                continue;
+            }
+            ledger.post(Account::FactoryExpense, Account::Treasury, job.cost, job.factory->nameRef());
+            for (std::uint32_t k = job.inBegin; k < job.inEnd; ++k) stock[flows_[k].res] -= flows_[k].qty;
+            for (std::uint32_t k = job.outBegin; k < job.outEnd; ++k) levelOut[flows_[k].res] += flows_[k].qty;
+        }
+
+        // iesirile nivelului devin disponibile pentru nivelurile urmatoare
+        for (std::size_t r = 0; r < resCount; ++r) {
+            stock[r] += levelOut[r];
+            produced[r] += levelOut[r];
+            levelOut[r] = 0;
+        }
+        begin = end;
+    }
+
+    for (std::size_t r = 0; r < resCount; ++r) {
+        if (stock[r] > start[r]) resources.add(resourceNames_[r], static_cast<int>(stock[r] - start[r]));
+        else if (stock[r] < start[r]) resources.consume(resourceNames_[r], static_cast<int>(start[r] - stock[r]));
+        if (produced[r] > 0) stats.add(resourceNames_[r], static_cast<long>(produced[r]));
+    }
+}
+
+std::size_t ProductionScheduler::levels() const noexcept {
+    return levelEnd_.size();
+}
+
+std::size_t ProductionScheduler::factoryCount() const noexcept {
+    return jobs_.size();
+}
+
+const std::vector<std::shared_ptr<FactoryBuilding>>& ProductionScheduler::blocked() const noexcept {
+    return blocked_;
+}
+
+std::size_t ProductionScheduler::memoryUsage() const noexcept {
+    std::size_t total = sizeof(*this) + resourceNames_.capacity() * sizeof(std::string) + mapMemory(resourceIds_);
+    for (const auto& n : resourceNames_) total += stringHeap(n);
+    return total + flows_.capacity() * sizeof(Flow) + jobs_.capacity() * sizeof(Job) + levelEnd_.capacity() * sizeof(std::size_t)
+         + blocked_.capacity() * sizeof(std::shared_ptr<FactoryBuilding>);
+}
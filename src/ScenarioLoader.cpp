@@ -0,0 +1,156 @@
+#include "../include/ScenarioLoader.hpp"
+#include "../include/Building.hpp"
+#include "../include/City.hpp"
+#include "../include/Exceptions.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Record {
+    bool hasStreet = false;
+    std::size_t street = 0;
+    std::shared_ptr<Building> building;
+    std::exception_ptr error;
+};
+
+class Tokens {
+    std::string_view text_;
+    std::size_t pos_ = 0;
+
+public:
+    explicit Tokens(std::string_view text) : text_(text) {}
+
+    bool next(std::string_view& tok) {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) ++pos_;
+        if (pos_ == text_.size()) return false;
+        std::size_t start = pos_;
+        while (pos_ < text_.size() && !std::isspace(static_cast<unsigned char>(text_[pos_]))) ++pos_;
+        tok = text_.substr(start, pos_ - start);
+        return true;
+    }
+
+    std::string_view expect() {
+        std::string_view tok;
+        if (!next(tok)) throw CityException("Incomplete BUILDING record");
+        return tok;
+    }
+};
+
+int toInt(std::string_view tok) {
+    int v = 0;
+    auto [ptr, ec] = std::from_chars(tok.data(), tok.data() + tok.size(), v);
+    if (ec != std::errc{} || ptr != tok.data() + tok.size())
+        throw CityException("Invalid number in BUILDING record: " + std::string(tok));
+    return v;
+}
+
+bool isBuildingLine(std::string_view text, std::size_t pos) {
+    constexpr std::string_view tag = "BUILDING";
+    if (text.compare(pos, tag.size(), tag) != 0) return false;
+    std::size_t after = pos + tag.size();
+    return after == text.size() || std::isspace(static_cast<unsigned char>(text[after]));
+}
+
+// taieturile cad doar la inceputul unei linii care incepe cu BUILDING
+std::vector<std::size_t> splitChunks(std::string_view text, std::size_t chunkBytes) {
+    std::vector<std::size_t> cuts{0};
+    std::size_t pos = chunkBytes;
+    while (pos < text.size()) {
+        std::size_t nl = text.find('\n', pos);
+        while (nl != std::string_view::npos && !isBuildingLine(text, nl + 1)) nl = text.find('\n', nl + 1);
+        if (nl == std::string_view::npos) break;
+        cuts.push_back(nl + 1);
+        pos = nl + 1 + chunkBytes;
+    }
+    cuts.push_back(text.size());
+    return cuts;
+}
+
+// parseaza si construieste toate inregistrarile unei bucati; prima eroare opreste bucata
+void parseChunk(std::string_view text, const std::vector<const Street*>& streets, std::vector<Record>& out) {
+    Tokens tokens(text);
+    std::string_view tag;
+    while (tokens.next(tag)) {
+        Record rec;
+        try {
+            if (tag != "BUILDING") throw CityException("Was expecting BUILDING");
+            std::string type(tokens.expect());
+            std::string name(tokens.expect());
+            const int streetIndex = toInt(tokens.expect());
+            rec.hasStreet = true;
+            rec.street = static_cast<std::size_t>(streetIndex);
+            const int paramCount = toInt(tokens.expect());
+            if (paramCount < 0) throw CityException("Negative parameter count in BUILDING record");
+            std::vector<std::string> params;
+            params.reserve(static_cast<std::size_t>(paramCount));
+            for (int j = 0; j < paramCount; ++j) params.emplace_back(tokens.expect());
+
+            const Street* st = rec.street < streets.size() ? streets[rec.street] : nullptr;
+            rec.building = BuildingCreator::instance().create(type, name, params, st);
+        } catch (...) {
+            rec.error = std::current_exception();
+            out.push_back(std::move(rec));
+            return;
+        }
+        out.push_back(std::move(rec));
+    }
+}
+
+}
+
+ScenarioLoader::ScenarioLoader(unsigned threads, std::size_t chunkBytes)
+    : threads_(threads), chunkBytes_(std::max<std::size_t>(chunkBytes, 1)) {}
+
+// citeste restul fluxului (BUILDINGS e ultima sectiune) si adauga `count` cladiri in oras
+void ScenarioLoader::loadBuildings(std::istream& in, int count, City& city) const {
+    const std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    const std::vector<std::size_t> cuts = splitChunks(text, chunkBytes_);
+    const std::size_t chunks = cuts.size() - 1;
+
+    // pointerii la strazi sunt luati pe firul principal, firele doar ii citesc
+    std::vector<const Street*> streets(city.streetCount());
+    for (std::size_t i = 0; i < streets.size(); ++i) streets[i] = city.getStreet(i);
+
+    unsigned threads = threads_ ? threads_ : std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::clamp<std::size_t>(chunks, 1, threads));
+
+    std::vector<std::vector<Record>> results(chunks);
+    std::atomic<std::size_t> next{0};
+    auto worker = [&]() {
+        for (std::size_t c = next++; c < chunks; c = next++)
+            parseChunk(std::string_view(text).substr(cuts[c], cuts[c + 1] - cuts[c]), streets, results[c]);
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& th : pool) th.join();
+
+    // integrare in ordinea din fisier; erorile apar exact unde ar fi aparut la incarcarea seriala
+    int added = 0;
+    for (auto& chunk : results) {
+        for (auto& rec : chunk) {
+            if (added == count) return;
+            if (rec.error) {
+                if (rec.hasStreet) {
+                    const Street* st = city.getStreet(rec.street);
+                    if (!st) throw InvalidIndexException();
+                    if (st->freeSlots() == 0) throw LimitExceededException();
+                }
+                std::rethrow_exception(rec.error);
+            }
+            city.addCreatedBuilding(std::move(rec.building), rec.street);
+            ++added;
+        }
+    }
+    if (added < count) throw CityException("Was expecting BUILDING");
+}
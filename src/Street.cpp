@@ -1,30 +1,135 @@
 #include "../include/Street.hpp"
+#include "../include/Exceptions.hpp"
+#include "../include/MemoryUsage.hpp"
 #include <algorithm>
+#include <bit>
+#include <sstream>
 
-// seteaza nivelul strazii in intervalul [1,3]
+namespace {
+
+// intretinerea unui segment pentru fiecare nivel
+constexpr std::array<Money, MAX_STREET_LEVEL + 1> UPKEEP_PER_SEGMENT{0, 1, 3, 6};
+
+}
+
+// seteaza nivelul strazii in intervalul [1,MAX_STREET_LEVEL]
 Street::Street(int lvl) noexcept
-    : level_(std::max(1, std::min(3, lvl))) {}
+    : level_(std::max(1, std::min(MAX_STREET_LEVEL, lvl))) {}
+
+Street::Street(const Street& other)
+    : length_(other.length_), level_(other.level_), occupied_(other.occupied_), freeHint_(other.freeHint_),
+      usedSlots_(other.usedSlots_), revision_(other.revision_), rendered_(other.rendered_),
+      renderedRevision_(other.renderedRevision_) {
+    chunks_.reserve(other.chunks_.size());
+    for (const auto& c : other.chunks_) chunks_.push_back(std::make_unique<Chunk>(*c));
+}
+
+Street& Street::operator=(const Street& other) {
+    if (this != &other) *this = Street(other);
+    return *this;
+}
 
 bool Street::addSegment(int seg) {
     // nu adaugam daca am atins limita
-    if (segments_.size() >= MAX_SEGMENTS) return false;
+    if (length_ >= MAX_SEGMENTS) return false;
+
+    if (length_ % SEGMENT_CHUNK == 0) chunks_.push_back(std::make_unique<Chunk>());
+    (*chunks_.back())[length_ % SEGMENT_CHUNK] = seg;
+    ++length_;
+    ++revision_;
 
-    // adaugam segmentul in vector
-    segments_.push_back(seg);
-    (void)seg; // evita warning daca seg nu e folosit in debug
+    // bitmap-ul de sloturi creste odata cu strada
+    occupied_.resize((static_cast<std::size_t>(slotCount()) + 63) / 64, 0);
+    return true;
+}
+
+bool Street::widen() noexcept {
+    if (level_ >= MAX_STREET_LEVEL) return false;
+    ++level_;
+    ++revision_;
     return true;
 }
 
 // lungimea strazii = numarul de segmente
 int Street::length() const noexcept {
-    return static_cast<int>(segments_.size());
+    return static_cast<int>(length_);
+}
+
+int Street::segment(std::size_t idx) const {
+    if (idx >= length_) throw InvalidIndexException();
+    return (*chunks_[idx / SEGMENT_CHUNK])[idx % SEGMENT_CHUNK];
+}
+
+Money Street::upkeep() const noexcept {
+    return static_cast<Money>(length_) * UPKEEP_PER_SEGMENT[static_cast<std::size_t>(level_)];
+}
+
+std::size_t Street::memoryUsage() const noexcept {
+    return sizeof(*this) + chunks_.capacity() * sizeof(chunks_[0]) + chunks_.size() * sizeof(Chunk)
+         + occupied_.capacity() * sizeof(std::uint64_t)
+         + stringHeap(rendered_);
 }
 
-// returneaza nivelul strazii (1–3)
+std::uint64_t Street::revision() const noexcept {
+    return revision_;
+}
+
+const std::string& Street::rendered() const {
+    if (renderedRevision_ != revision_) {
+        std::ostringstream os;
+        os << *this;
+        rendered_ = std::move(os).str();
+        renderedRevision_ = revision_;
+    }
+    return rendered_;
+}
+
+// returneaza nivelul strazii (1–MAX_STREET_LEVEL)
 int Street::level() const noexcept {
     return level_;
 }
 
+int Street::slotCount() const noexcept {
+    return length() * SLOTS_PER_SEGMENT;
+}
+
+int Street::freeSlots() const noexcept {
+    return slotCount() - usedSlots_;
+}
+
+bool Street::isOccupied(int slot) const noexcept {
+    if (slot < 0 || slot >= slotCount()) return false;
+    return (occupied_[static_cast<std::size_t>(slot) / 64] >> (slot % 64)) & 1u;
+}
+
+// primul slot liber, cautat cu bit scan pe cuvinte de 64 de biti, de la primul cuvant care nu e plin
+int Street::firstFreeSlot() const noexcept {
+    if (usedSlots_ == slotCount()) return -1;
+    for (std::size_t w = freeHint_; w < occupied_.size(); ++w) {
+        if (~occupied_[w] == 0) continue;
+        int slot = static_cast<int>(w * 64) + std::countr_one(occupied_[w]);
+        return slot < slotCount() ? slot : -1;
+    }
+    return -1;
+}
+
+// ocupa primul slot liber; -1 daca strada e plina
+int Street::occupySlot() {
+    int slot = firstFreeSlot();
+    if (slot < 0) return -1;
+    freeHint_ = static_cast<std::size_t>(slot) / 64;
+    occupied_[freeHint_] |= std::uint64_t{1} << (slot % 64);
+    ++usedSlots_;
+    return slot;
+}
+
+void Street::releaseSlot(int slot) {
+    if (!isOccupied(slot)) throw InvalidIndexException();
+    occupied_[static_cast<std::size_t>(slot) / 64] &= ~(std::uint64_t{1} << (slot % 64));
+    freeHint_ = std::min(freeHint_, static_cast<std::size_t>(slot) / 64);
+    --usedSlots_;
+}
+
 // tipul drumului in functie de nivel
 std::string Street::roadType() const {
     switch (level_) {
@@ -36,6 +141,6 @@ std::string Street::roadType() const {
 }
 
 std::ostream& operator<<(std::ostream& os, const Street& s) {
-    os << "Street(segments=" << s.segments_.size() << ", " << s.roadType() << ")";
+    os << "Street(segments=" << s.length_ << ", " << s.roadType() << ")";
     return os;
 }
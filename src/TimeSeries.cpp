@@ -0,0 +1,170 @@
+#include "../include/TimeSeries.hpp"
+#include "../include/Exceptions.hpp"
+#include <algorithm>
+
+void SeriesSummary::merge(const SeriesSummary& o) noexcept {
+    if (o.count == 0) return;
+    if (count == 0) {
+        *this = o;
+        return;
+    }
+    count += o.count;
+    sum += o.sum;
+    min = std::min(min, o.min);
+    max = std::max(max, o.max);
+}
+
+double SeriesSummary::mean() const noexcept {
+    return count == 0 ? 0.0 : static_cast<double>(sum) / static_cast<double>(count);
+}
+
+const TimeSeries::Bucket& TimeSeries::Tier::at(std::size_t i) const {
+    return ring[(head + ring.size() - size + i) % ring.size()];
+}
+
+TimeSeries::TimeSeries(std::size_t capacityPerTier, std::size_t factor, std::size_t tiers, std::size_t window, double emaAlpha)
+    : factor_(factor), window_(window), alpha_(emaAlpha) {
+    if (factor_ < 2 || tiers == 0 || window_ == 0)
+        throw CityException("Invalid time series configuration");
+    if (alpha_ <= 0.0 || alpha_ > 1.0)
+        throw CityException("EMA factor must be in (0, 1]");
+    // nivelul 0 trebuie sa tina cel putin fereastra, ca sa stim ce esantion iese din ea;
+    // memoria se aloca pe masura ce vin esantioane, ca seriile scurte sa ramana mici
+    tiers_.resize(tiers);
+    for (auto& t : tiers_) t.capacity = std::max(capacityPerTier, window_);
+}
+
+// adauga bucket-ul pe un nivel si il agrega in bucket-ul in curs al nivelului urmator
+void TimeSeries::push(std::size_t tier, const Bucket& b) {
+    Tier& t = tiers_[tier];
+    if (t.ring.size() < t.capacity) {
+        t.ring.push_back(b);
+        t.head = t.ring.size() % t.capacity;
+    } else {
+        t.ring[t.head] = b;
+        t.head = (t.head + 1) % t.ring.size();
+    }
+    t.size = std::min(t.size + 1, t.capacity);
+
+    if (tier + 1 == tiers_.size()) return;
+    Tier& parent = tiers_[tier + 1];
+    if (parent.pendingChildren == 0) {
+        parent.pending = b;
+    } else {
+        parent.pending.s.merge(b.s);
+        parent.pending.last = b.last;
+    }
+    if (++parent.pendingChildren == factor_) {
+        parent.pendingChildren = 0;
+        push(tier + 1, parent.pending);
+    }
+}
+
+// O(1) amortizat: suma ferestrei, min/max cu cozi monotone, EMA
+void TimeSeries::record(std::uint64_t tick, long long value) {
+    if (samples_ > 0 && tick <= lastTick_)
+        throw CityException("Time series ticks must be increasing");
+
+    const Tier& raw = tiers_[0];
+    if (raw.size >= window_) windowSum_ -= raw.at(raw.size - window_).s.sum;
+    windowSum_ += value;
+
+    const std::uint64_t idx = samples_;
+    while (!minQ_.empty() && minQ_.back().second >= value) minQ_.pop_back();
+    while (!maxQ_.empty() && maxQ_.back().second <= value) maxQ_.pop_back();
+    minQ_.emplace_back(idx, value);
+    maxQ_.emplace_back(idx, value);
+    while (minQ_.front().first + window_ <= idx) minQ_.pop_front();
+    while (maxQ_.front().first + window_ <= idx) maxQ_.pop_front();
+
+    ema_ = samples_ == 0 ? static_cast<double>(value) : alpha_ * static_cast<double>(value) + (1.0 - alpha_) * ema_;
+    last_ = value;
+    lastTick_ = tick;
+    ++samples_;
+
+    push(0, Bucket{tick, tick, SeriesSummary{1, value, value, value}});
+}
+
+long long TimeSeries::last() const noexcept {
+    return last_;
+}
+
+double TimeSeries::ema() const noexcept {
+    return ema_;
+}
+
+SeriesSummary TimeSeries::window() const noexcept {
+    SeriesSummary s;
+    if (samples_ == 0) return s;
+    s.count = std::min<std::uint64_t>(samples_, window_);
+    s.sum = windowSum_;
+    s.min = minQ_.front().second;
+    s.max = maxQ_.front().second;
+    return s;
+}
+
+// bucket-urile unui nivel care ating intervalul; ce e mai nou decat ultimul bucket
+// inchis se cauta pe nivelul mai fin
+void TimeSeries::collect(std::size_t tier, std::uint64_t from, std::uint64_t to, SeriesSummary& out) const {
+    const Tier& t = tiers_[tier];
+    std::size_t lo = 0, hi = t.size;
+    while (lo < hi) {
+        std::size_t mid = (lo + hi) / 2;
+        if (t.at(mid).last < from) lo = mid + 1;
+        else hi = mid;
+    }
+    for (std::size_t i = lo; i < t.size && t.at(i).first <= to; ++i)
+        out.merge(t.at(i).s);
+
+    if (tier == 0) return;
+    std::uint64_t next = t.size > 0 ? std::max(from, t.at(t.size - 1).last + 1) : from;
+    if (next <= to) collect(tier - 1, next, to, out);
+}
+
+// interogare pe interval [from, to]; pe nivelurile grosiere bucket-urile de la margini sunt incluse integral
+SeriesSummary TimeSeries::range(std::uint64_t from, std::uint64_t to) const {
+    SeriesSummary out;
+    if (samples_ == 0 || from > to) return out;
+
+    std::size_t tier = 0;
+    while (tier + 1 < tiers_.size() && (tiers_[tier].size == 0 || tiers_[tier].at(0).first > from))
+        ++tier;
+    collect(tier, from, to, out);
+    return out;
+}
+
+std::uint64_t TimeSeries::samples() const noexcept {
+    return samples_;
+}
+
+std::size_t TimeSeries::memoryUsage() const noexcept {
+    std::size_t total = sizeof(*this) + tiers_.capacity() * sizeof(Tier);
+    for (const auto& t : tiers_) total += t.ring.capacity() * sizeof(Bucket);
+    total += (minQ_.size() + maxQ_.size()) * sizeof(std::pair<std::uint64_t, long long>);
+    return total;
+}
+
+void CityMetrics::sample(std::uint64_t tick, long long money, long long capacity, const std::map<std::string, int>& stock) {
+    money_.record(tick, money);
+    capacity_.record(tick, capacity);
+    for (const auto& kv : stock) stock_[kv.first].record(tick, kv.second);
+}
+
+const TimeSeries& CityMetrics::money() const noexcept {
+    return money_;
+}
+
+const TimeSeries& CityMetrics::capacity() const noexcept {
+    return capacity_;
+}
+
+const TimeSeries* CityMetrics::stock(const std::string& resource) const {
+    auto it = stock_.find(resource);
+    return it == stock_.end() ? nullptr : &it->second;
+}
+
+std::size_t CityMetrics::memoryUsage() const noexcept {
+    std::size_t total = money_.memoryUsage() + capacity_.memoryUsage();
+    for (const auto& kv : stock_) total += kv.first.capacity() + kv.second.memoryUsage();
+    return total;
+}